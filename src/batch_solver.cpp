@@ -0,0 +1,123 @@
+/*
+	SPDX-FileCopyrightText: 2026 Graeme Gott <graeme@gottcode.org>
+
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include "batch_solver.h"
+
+#include "solver.h"
+#include "trie.h"
+
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <utility>
+
+//-----------------------------------------------------------------------------
+
+BatchSolver::BatchSolver(const Trie& words, int minimum)
+	: m_words(&words)
+	, m_minimum(minimum)
+	, m_max_words(-1)
+	, m_keep_words(false)
+	, m_thread_count(QThread::idealThreadCount())
+	, m_width(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void BatchSolver::setMaximumWords(int max)
+{
+	m_max_words = max;
+}
+
+//-----------------------------------------------------------------------------
+
+void BatchSolver::setKeepWords(bool keep)
+{
+	m_keep_words = keep;
+}
+
+//-----------------------------------------------------------------------------
+
+void BatchSolver::setThreadCount(int count)
+{
+	m_thread_count = std::max(1, count);
+}
+
+//-----------------------------------------------------------------------------
+
+void BatchSolver::setWidth(int width)
+{
+	m_width = std::max(0, width);
+}
+
+//-----------------------------------------------------------------------------
+
+QList<BatchSolver::Result> BatchSolver::solve(const QList<QStringList>& boards) const
+{
+	QList<Result> results(boards.count());
+	Result* const output = results.data();
+	std::atomic<qsizetype> next(0);
+
+	QThreadPool pool;
+	const int count = std::min(m_thread_count, int(std::max(qsizetype(1), boards.count())));
+	pool.setMaxThreadCount(count);
+	for (int i = 0; i < count; ++i) {
+		pool.start([this, &boards, output, &next] {
+			// Keep a solver for each board size so that their memory is reused
+			std::map<std::pair<int, int>, std::unique_ptr<Solver>> solvers;
+
+			for (qsizetype index = next++; index < boards.count(); index = next++) {
+				const QStringList& letters = boards.at(index);
+				int width = 0;
+				int height = 0;
+				if (!boardSize(letters.count(), width, height)) {
+					continue;
+				}
+
+				std::unique_ptr<Solver>& solver = solvers[std::make_pair(width, height)];
+				if (!solver) {
+					solver = std::make_unique<Solver>(*m_words, width, height, m_minimum);
+				}
+				solver->solve(letters);
+
+				Result& result = output[index];
+				result.count = solver->count();
+				result.score = solver->score(m_max_words);
+				if (m_keep_words) {
+					result.words = solver->words();
+				}
+			}
+		});
+	}
+	pool.waitForDone();
+
+	return results;
+}
+
+//-----------------------------------------------------------------------------
+
+bool BatchSolver::boardSize(int count, int& width, int& height) const
+{
+	if ((count < 1) || (count > 64)) {
+		return false;
+	}
+
+	if (m_width) {
+		width = m_width;
+		height = count / m_width;
+	} else {
+		width = height = std::lround(std::sqrt(count));
+	}
+	return (width * height) == count;
+}
+
+//-----------------------------------------------------------------------------
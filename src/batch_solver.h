@@ -0,0 +1,92 @@
+/*
+	SPDX-FileCopyrightText: 2026 Graeme Gott <graeme@gottcode.org>
+
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef TANGLET_BATCH_SOLVER_H
+#define TANGLET_BATCH_SOLVER_H
+
+#include <QList>
+#include <QStringList>
+
+class Trie;
+
+/**
+ * @brief The BatchSolver class solves many boards at once without a game.
+ *
+ * Boards are handed out to threads one at a time, and each thread keeps its own solver for each
+ * board size so that solving a board does not allocate anything that the last board did not.
+ */
+class BatchSolver
+{
+public:
+	/**
+	 * @brief The BatchSolver::Result struct holds what was found on a board.
+	 */
+	struct Result
+	{
+		int count = -1; /**< how many different words are on the board, or @c -1 if it was not solved */
+		int score = 0; /**< the maximum score available on the board */
+		QStringList words; /**< sorted words on the board if they were kept */
+	};
+
+	/**
+	 * Constructs a batch solver instance.
+	 * @param words the optimized word list
+	 * @param minimum the shortest allowed word
+	 */
+	BatchSolver(const Trie& words, int minimum);
+
+	/**
+	 * Sets how many words are counted towards the score of a board.
+	 * @param max how many words to limit the score to, or @c -1 for all of them
+	 */
+	void setMaximumWords(int max);
+
+	/**
+	 * Sets if the words found on each board are kept in the results.
+	 * @param keep whether to keep the words
+	 */
+	void setKeepWords(bool keep);
+
+	/**
+	 * Sets how many threads solve boards.
+	 * @param count how many threads to use
+	 */
+	void setThreadCount(int count);
+
+	/**
+	 * Sets how wide the boards are.
+	 * @param width how many cells wide the boards are, or @c 0 if they are square
+	 */
+	void setWidth(int width);
+
+	/**
+	 * Finds the words on each board. Boards whose number of cells does not fit the width, or
+	 * that have more than 64 cells, are not solved.
+	 * @param boards the board layouts
+	 * @return what was found on each board in the same order as @p boards
+	 */
+	QList<Result> solve(const QList<QStringList>& boards) const;
+
+private:
+	/**
+	 * Finds the size of a board.
+	 * @param count how many cells are on the board
+	 * @param[out] width how many cells wide is the board
+	 * @param[out] height how many cells tall is the board
+	 * @return @c true if the board has a valid size
+	 */
+	bool boardSize(int count, int& width, int& height) const;
+
+private:
+	const Trie* m_words; /**< fast access word list */
+	int m_minimum; /**< the shortest allowed word */
+	int m_max_words; /**< how many words count towards the score */
+	bool m_keep_words; /**< whether to store the words of each board */
+	int m_thread_count; /**< how many threads solve boards */
+	int m_width; /**< how many cells wide the boards are, or 0 for square boards */
+};
+
+#endif // TANGLET_BATCH_SOLVER_H
@@ -201,7 +201,7 @@ void Board::abort()
 
 //-----------------------------------------------------------------------------
 
-bool Board::generate(const QSettings& game)
+bool Board::generate(const QSettings& game, quint64 seed)
 {
 	constexpr unsigned int TANGLET_FILE_VERSION = 3;
 
@@ -221,9 +221,17 @@ bool Board::generate(const QSettings& game)
 	}
 	int timer = qBound(0, game.value("TimerMode").toInt(), Clock::TotalTimers - 1);
 	QStringList letters = game.value("Letters").toStringList();
+	if (!seed) {
+		seed = game.value("Seed").toULongLong();
+	}
+
+	// Boards with a seed are found with the density stored in their seed
+	if (seed) {
+		density = seed % 3;
+	}
 
-	// Verify board size
-	if (game.contains("Version") && ((size * size) != letters.size())) {
+	// Verify board size, unless the board is replayed from its seed
+	if (game.contains("Version") && (!letters.isEmpty() || !seed) && ((size * size) != letters.size())) {
 		return false;
 	}
 
@@ -248,11 +256,14 @@ bool Board::generate(const QSettings& game)
 		if (!letters.isEmpty()) {
 			settings.setValue("Letters", letters);
 		}
+		if (seed) {
+			settings.setValue("Seed", seed);
+		}
 	}
 
 	// Create new game
 	m_generator->cancel();
-	m_generator->create(density, size, minimum, timer, letters);
+	m_generator->create(density, size, size, minimum, timer, letters, seed);
 
 	return true;
 }
@@ -327,8 +338,8 @@ void Board::gameStarted()
 	settings.beginGroup("Current");
 
 	m_clock->setTimer(m_generator->timer());
-	if (m_generator->size() != m_size) {
-		m_size = m_generator->size();
+	if (m_generator->width() != m_size) {
+		m_size = m_generator->width();
 		m_cells = QList<QList<Letter*>>(m_size, QList<Letter*>(m_size));
 		m_maximum = m_size * m_size;
 		m_guess->setMaxLength(m_maximum);
@@ -344,6 +355,10 @@ void Board::gameStarted()
 	m_missed->setDictionary(m_generator->dictionary());
 	m_missed->setTrie(m_generator->trie());
 	settings.setValue("Letters", m_letters);
+	settings.setValue("Seed", m_generator->seed());
+	if (m_generator->seed()) {
+		settings.setValue("Density", m_generator->seed() % 3);
+	}
 
 	// Create board
 	QFont f = font();
@@ -56,9 +56,10 @@ public:
 	/**
 	 * Creates a new game in a thread, replacing the contents of the game board.
 	 * @param game the details to use to create a game
+	 * @param seed the seed of a board to replay instead of the seed in @p game, or @c 0
 	 * @return @c true if the game is valid and will be started
 	 */
-	bool generate(const QSettings& game);
+	bool generate(const QSettings& game, quint64 seed = 0);
 
 	/**
 	 * Pauses or resumes the game.
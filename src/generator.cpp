@@ -7,27 +7,56 @@
 #include "generator.h"
 
 #include "clock.h"
-#include "gzip.h"
 #include "language_settings.h"
 #include "solver.h"
 #include "trie.h"
 
 #include <QCryptographicHash>
-#include <QDataStream>
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QRandomGenerator>
+#include <QSaveFile>
 #include <QSettings>
 #include <QTextStream>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <cmath>
 
 //-----------------------------------------------------------------------------
 
 namespace
 {
 
+constexpr int pool_size = 10; /**< how many boards are kept ready for each kind of game */
+constexpr int cache_limit = 5; /**< how many word lists are kept cached */
+
+constexpr double anneal_heat = 0.25; /**< starting temperature of annealing as a fraction of the word range */
+constexpr double anneal_cooling = 10.0; /**< how many times colder annealing gets before it reheats */
+constexpr int anneal_steps = 10; /**< how many changes for each cell it takes annealing to cool */
+
+/**
+ * Makes the seed of a search. The density and strategy are stored in the seed so that a board
+ * can be replayed from its seed alone, and the seed is never @c 0.
+ * @param random the random number generator
+ * @param density how many words are in the layout
+ * @param strategy how the board is searched for
+ * @return the seed of a search
+ */
+quint64 searchSeed(Random& random, int density, Generator::Strategy strategy)
+{
+	return ((random.generate64() >> 3) * 6) + (strategy * 3) + density + 6;
+}
+
 /**
  * @brief The State class represents a current game being built.
+ *
+ * The board is described by which die is in each cell and which face of that die is up, as
+ * indexes into a dice table that never changes. Each change is made in place and can be undone,
+ * and the paths of words are kept for both the accepted board and the changed board, so that
+ * searching does not copy the state or allocate memory.
  */
 struct State
 {
@@ -38,12 +67,23 @@ struct State
 	 * @param target the target amount of words
 	 * @param random the random number generator
 	 */
-	State(const QList<QStringList>& dice, Solver* solver, int target, QRandomGenerator* random)
+	State(const QList<QStringList>& dice, Solver* solver, int target, Random* random)
 		: m_dice(dice)
+		, m_order(dice.count())
+		, m_faces(dice.count())
+		, m_letters(dice.count())
 		, m_solver(solver)
 		, m_target(target)
+		, m_delta(0)
 		, m_random(random)
+		, m_undo_cell1(-1)
+		, m_undo_cell2(-1)
+		, m_undo_face(-1)
+		, m_undo_delta(0)
 	{
+		for (int i = 0, count = m_order.count(); i < count; ++i) {
+			m_order[i] = i;
+		}
 	}
 
 	/**
@@ -63,22 +103,52 @@ struct State
 	}
 
 	/**
-	 * Flips individual dice to tweak the board and searches it for solutions.
+	 * Keeps the change made by the last call to permute().
+	 */
+	void accept()
+	{
+		m_paths.swap(m_next_paths);
+		m_undo_cell1 = -1;
+	}
+
+	/**
+	 * Flips an individual die or swaps two dice to tweak the board and searches it for
+	 * solutions. The change must be kept with accept() or undone with reject() before the next
+	 * change.
 	 */
 	void permute()
 	{
+		m_undo_delta = m_delta;
 		if (m_random->bounded(2)) {
-			const int index = m_random->bounded(m_dice.count());
-			QStringList& die = m_dice[index];
-			std::shuffle(die.begin(), die.end(), *m_random);
-			m_letters[index] = m_dice.at(index).first();
+			m_undo_cell1 = m_undo_cell2 = m_random->bounded(m_order.count());
+			m_undo_face = m_faces.at(m_undo_cell1);
+			m_faces[m_undo_cell1] = m_random->bounded(m_dice.at(m_order.at(m_undo_cell1)).count());
+			updateLetter(m_undo_cell1);
+		} else {
+			m_undo_cell1 = m_random->bounded(m_order.count());
+			m_undo_cell2 = m_random->bounded(m_order.count());
+			m_undo_face = -1;
+			swapDice(m_undo_cell1, m_undo_cell2);
+		}
+		m_delta = solve(m_paths, m_next_paths);
+	}
+
+	/**
+	 * Undoes the change made by the last call to permute().
+	 */
+	void reject()
+	{
+		if (m_undo_cell1 == -1) {
+			return;
+		}
+		if (m_undo_face != -1) {
+			m_faces[m_undo_cell1] = m_undo_face;
+			updateLetter(m_undo_cell1);
 		} else {
-			const int index1 = m_random->bounded(m_dice.count());
-			const int index2 = m_random->bounded(m_dice.count());
-			m_dice.swapItemsAt(index1, index2);
-			m_letters.swapItemsAt(index1, index2);
+			swapDice(m_undo_cell1, m_undo_cell2);
 		}
-		solve();
+		m_delta = m_undo_delta;
+		m_undo_cell1 = -1;
 	}
 
 	/**
@@ -86,36 +156,70 @@ struct State
 	 */
 	void roll()
 	{
-		std::shuffle(m_dice.begin(), m_dice.end(), *m_random);
-		m_letters.clear();
-		int count = m_dice.count();
-		for (int i = 0; i < count; ++i) {
-			QStringList& die = m_dice[i];
-			std::shuffle(die.begin(), die.end(), *m_random);
-			m_letters += die.first();
+		// Shuffle by hand, because std::shuffle() differs between standard libraries
+		for (int i = m_order.count() - 1; i > 0; --i) {
+			std::swap(m_order[i], m_order[m_random->bounded(i + 1)]);
+		}
+		for (int i = 0, count = m_order.count(); i < count; ++i) {
+			m_faces[i] = m_random->bounded(m_dice.at(m_order.at(i)).count());
+			updateLetter(i);
 		}
-		solve();
+		m_delta = solve(Solver::Paths(), m_next_paths);
+		accept();
 	}
 
 private:
 	/**
 	 * Searches the board for solutions and determines how far off the amount of words is from the
-	 * target amount of words.
+	 * target amount of words. Only the cells that have changed since the previous paths were
+	 * found are searched again.
+	 * @param previous the paths of the board before it was changed
+	 * @param[out] paths replaced by the paths of the board
+	 * @return how far off the amount of words is from the target amount of words
+	 */
+	int solve(const Solver::Paths& previous, Solver::Paths& paths)
+	{
+		int words = m_solver->countWords(m_letters, previous, paths);
+		return abs(words - m_target);
+	}
+
+	/**
+	 * Exchanges the dice in two cells.
+	 * @param cell1 the first cell
+	 * @param cell2 the second cell
+	 */
+	void swapDice(int cell1, int cell2)
+	{
+		m_order.swapItemsAt(cell1, cell2);
+		m_faces.swapItemsAt(cell1, cell2);
+		m_letters.swapItemsAt(cell1, cell2);
+	}
+
+	/**
+	 * Shows the face that is up in a cell in the layout.
+	 * @param cell the cell to update
 	 */
-	void solve()
+	void updateLetter(int cell)
 	{
-		m_solver->solve(m_letters);
-		int words = m_solver->count();
-		m_delta = abs(words - m_target);
+		m_letters[cell] = m_dice.at(m_order.at(cell)).at(m_faces.at(cell));
 	}
 
 private:
-	QList<QStringList> m_dice; /**< the dice used to generate a layout */
+	const QList<QStringList>& m_dice; /**< the dice used to generate a layout, which are never changed */
+	QList<int> m_order; /**< which die is in each cell */
+	QList<int> m_faces; /**< which face of the die in each cell is up */
 	QStringList m_letters; /**< the generated layout */
 	Solver* m_solver; /**< solves the generated layout */
+	Solver::Paths m_paths; /**< paths of words on the accepted layout, to only search changed cells */
+	Solver::Paths m_next_paths; /**< paths of words on the changed layout */
 	int m_target; /**< the target number of words on generated board */
 	int m_delta; /**< how far the actual number of words is from the target */
-	QRandomGenerator* m_random; /**< random number generator */
+	Random* m_random; /**< random number generator */
+
+	int m_undo_cell1; /**< the cell changed by the last change, or @c -1 if there is nothing to undo */
+	int m_undo_cell2; /**< the other cell of a swap, or the same cell for a flip */
+	int m_undo_face; /**< the face that was up before a flip, or @c -1 for a swap */
+	int m_undo_delta; /**< how far off the target the board was before the last change */
 };
 
 }
@@ -123,15 +227,29 @@ private:
 //-----------------------------------------------------------------------------
 
 QString Generator::m_cache_path;
+Generator::Strategy Generator::m_default_strategy = Generator::HillClimbing;
 
 //-----------------------------------------------------------------------------
 
 Generator::Generator(QObject* parent)
 	: QThread(parent)
-	, m_random(QRandomGenerator::securelySeeded())
+	, m_words_size(0)
+	, m_random(QRandomGenerator::system()->generate64())
+	, m_strategy(m_default_strategy)
 	, m_max_score(0)
+	, m_seed(0)
 	, m_canceled(false)
+	, m_refill_stopped(false)
+{
+	m_refill_pool.setMaxThreadCount(1);
+	m_refill_pool.setThreadPriority(QThread::IdlePriority);
+}
+
+//-----------------------------------------------------------------------------
+
+Generator::~Generator()
 {
+	stopRefill();
 }
 
 //-----------------------------------------------------------------------------
@@ -141,19 +259,25 @@ void Generator::cancel()
 	blockSignals(true);
 	m_canceled.store(true, std::memory_order_relaxed);
 	wait();
+	stopRefill();
 	blockSignals(false);
 }
 
 //-----------------------------------------------------------------------------
 
-void Generator::create(int density, int size, int minimum, int timer, const QStringList& letters)
+void Generator::create(int density, int width, int height, int minimum, int timer, const QStringList& letters, quint64 seed)
 {
+	stopRefill();
+
+	m_strategy = seed ? Strategy((seed / 3) % 2) : m_default_strategy;
 	m_density = density;
-	m_size = size;
+	m_width = width;
+	m_height = height;
 	m_minimum = minimum;
 	m_timer = timer;
 	m_max_words = (m_timer != Clock::Allotment) ? -1 : 30;
 	m_letters = letters;
+	m_seed = seed;
 	m_canceled.store(false, std::memory_order_relaxed);
 	m_max_score = 0;
 	m_solutions.clear();
@@ -162,6 +286,37 @@ void Generator::create(int density, int size, int minimum, int timer, const QStr
 
 //-----------------------------------------------------------------------------
 
+QList<QStringList> Generator::dice(int width, int height) const
+{
+	const int count = width * height;
+	const auto i = m_dice.constFind(count);
+	if (i != m_dice.constEnd()) {
+		return *i;
+	}
+
+	// Find the smallest set that is large enough, or the largest set
+	int size = 0;
+	for (auto j = m_dice.cbegin(), end = m_dice.cend(); j != end; ++j) {
+		const int key = j.key();
+		if ((size < count) ? (key > size) : ((key >= count) && (key < size))) {
+			size = key;
+		}
+	}
+	if (!size) {
+		return QList<QStringList>(count, QStringList("?"));
+	}
+
+	const QList<QStringList> set = m_dice.value(size);
+	QList<QStringList> result;
+	result.reserve(count);
+	for (int j = 0; j < count; ++j) {
+		result.append(set.at(j % set.count()));
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+
 void Generator::run()
 {
 	update();
@@ -170,7 +325,7 @@ void Generator::run()
 	}
 
 	// Store solutions for loaded board
-	Solver solver(m_words, m_size, m_minimum);
+	Solver solver(m_words, m_width, m_height, m_minimum);
 	if (!m_letters.isEmpty()) {
 		solver.solve(m_letters);
 		m_max_score = solver.score(m_max_words);
@@ -178,12 +333,17 @@ void Generator::run()
 		return;
 	}
 
-	if (m_density == 3) {
-		m_density = m_random.bounded(0, 3);
+	// Replayed boards store their density in their seed
+	if (m_seed) {
+		m_density = m_seed % 3;
+	} else if (m_density == 3) {
+		m_density = m_random.bounded(3);
 	}
 
-	// Find word range
-	int offset = ((m_size == 4) ? 6 : 7) - m_minimum;
+	// Find word range, which is set for 4x4 and 5x5 boards and scaled by cells for other sizes
+	const int cells = m_width * m_height;
+	const int base_cells = (cells <= 16) ? 16 : 25;
+	int offset = ((base_cells == 16) ? 6 : 7) - m_minimum;
 	int words_target = 0, words_range = 0;
 	switch (m_density) {
 	case 0:
@@ -201,24 +361,115 @@ void Generator::run()
 	default:
 		break;
 	}
+	words_target = (words_target * cells) / base_cells;
+	words_range = std::max(1, (words_range * cells) / base_cells);
+
+	// Replay the search of a previous board
+	const Search details{ m_words, dice(m_width, m_height), m_width, m_height, m_minimum, m_strategy, words_target, words_range };
+	if (m_seed) {
+		std::atomic<bool> found(false);
+		m_letters = search(details, m_seed, found);
+		if (!m_letters.isEmpty()) {
+			solver.solve(m_letters);
+			m_max_score = solver.score(m_max_words);
+			m_solutions = solver.solutions();
+		}
+		return;
+	}
+
+	// Take a board from the pool, or search for one with several chains at once
+	const QString pool_path = poolPath();
+	QStringList letters = takePooledBoard(pool_path, m_seed);
+	if (letters.isEmpty()) {
+		const int chains = std::max(1, idealThreadCount());
+		std::atomic<bool> found(false);
+		QThreadPool pool;
+		pool.setMaxThreadCount(chains);
+		for (int i = 0; i < chains; ++i) {
+			const quint64 seed = searchSeed(m_random, m_density, m_strategy);
+			pool.start([this, &details, seed, &found, &letters] {
+				const QStringList result = search(details, seed, found);
+				if (!result.isEmpty() && !found.exchange(true)) {
+					letters = result;
+					m_seed = seed;
+				}
+			});
+		}
+		pool.waitForDone();
+		if (letters.isEmpty()) {
+			return;
+		}
+	}
+
+	// Store solutions for generated board
+	m_letters = letters;
+	solver.solve(m_letters);
+	m_max_score = solver.score(m_max_words);
+	m_solutions = solver.solutions();
+
+	refillPool(pool_path, details);
+}
+
+//-----------------------------------------------------------------------------
+
+QStringList Generator::search(const Search& details, quint64 seed, std::atomic<bool>& found) const
+{
+	Random random(seed);
+	Solver solver(details.words, details.width, details.height, details.minimum);
 
 	// Create board state
-	solver.setTrackPositions(false);
-	State current(dice(m_size), &solver, words_target, &m_random);
+	State current(details.dice, &solver, details.target, &random);
 	current.roll();
-	State next = current;
 
-	int max_tries = m_size * m_size * 2;
+	if (details.strategy == Annealing) {
+		// Cool from a fraction of the word range, then reheat once cold
+		const double hot = std::max(details.range, 1) * anneal_heat;
+		const double cold = hot / anneal_cooling;
+		const double cooling = std::pow(cold / hot, 1.0 / (details.width * details.height * anneal_steps));
+		double temperature = hot;
+		do {
+			if (m_canceled.load(std::memory_order_relaxed) || found.load(std::memory_order_relaxed)) {
+				return QStringList();
+			}
+
+			// Change the board
+			const int delta = current.delta();
+			current.permute();
+
+			// Accept worse boards less often as the search cools
+			const int change = current.delta() - delta;
+			if ((change <= 0) || (random.generateDouble() < std::exp(-change / temperature))) {
+				current.accept();
+			} else {
+				current.reject();
+			}
+
+			temperature *= cooling;
+			if (temperature < cold) {
+				temperature = hot;
+			}
+		} while (current.delta() > details.range);
+
+		return current.letters();
+	}
+
+	int max_tries = details.width * details.height * 2;
+	int max_loops = std::max(details.width, details.height);
 	int tries = 0;
 	int loops = 0;
 	do {
+		if (m_canceled.load(std::memory_order_relaxed) || found.load(std::memory_order_relaxed)) {
+			return QStringList();
+		}
+
 		// Change the board
-		next = current;
-		next.permute();
+		const int delta = current.delta();
+		current.permute();
 
 		// Check if this is a better board
-		if (next.delta() < current.delta()) {
-			current = next;
+		bool keep = false;
+		if (current.delta() < delta) {
+			keep = true;
 			tries = 0;
 			loops = 0;
 		}
@@ -226,24 +477,161 @@ void Generator::run()
 		// Prevent getting stuck at local minimum
 		tries++;
 		if (tries == max_tries) {
-			current = next;
+			keep = true;
 			tries = 0;
 			loops++;
+		}
+
+		if (keep) {
+			current.accept();
+		} else {
+			current.reject();
+		}
+
+		// Restart if still stuck at local minimum
+		if (loops == max_loops) {
+			current.roll();
+			loops = 0;
+		}
+	} while (current.delta() > details.range);
+
+	return current.letters();
+}
+
+//-----------------------------------------------------------------------------
+
+QString Generator::poolPath() const
+{
+	return QString("%1/boards-%2-%3-%4x%5-%6-%7-%8")
+			.arg(m_cache_path, QString::fromLatin1(m_words_hash), QString::fromLatin1(m_dice_hash))
+			.arg(m_width)
+			.arg(m_height)
+			.arg(m_density)
+			.arg(m_minimum)
+			.arg(m_strategy);
+}
+
+//-----------------------------------------------------------------------------
+
+QStringList Generator::takePooledBoard(const QString& path, quint64& seed) const
+{
+	QFile file(path);
+	if (!file.open(QFile::ReadOnly | QIODevice::Text)) {
+		return QStringList();
+	}
+	QStringList boards;
+	QTextStream stream(&file);
+	while (!stream.atEnd()) {
+		const QString line = stream.readLine();
+		if (!line.isEmpty()) {
+			boards.append(line);
+		}
+	}
+	file.close();
+	if (boards.isEmpty()) {
+		return QStringList();
+	}
+
+	// Each board is stored as the seed that found it followed by its letters
+	const int count = m_width * m_height;
+	QStringList letters;
+	while (letters.isEmpty() && !boards.isEmpty()) {
+		const QString board = boards.takeFirst();
+		const int separator = board.indexOf(' ');
+		bool ok = false;
+		const quint64 board_seed = board.left(separator).toULongLong(&ok);
+		letters = board.mid(separator + 1).split(',');
+
+		// Skip boards that are damaged or that their seed would not replay
+		ok = ok && board_seed && ((board_seed % 3) == quint64(m_density)) && (((board_seed / 3) % 2) == quint64(m_strategy));
+		if (ok && (letters.count() == count)) {
+			seed = board_seed;
+		} else {
+			letters.clear();
+		}
+	}
+
+	// Write back the rest of the pool
+	QSaveFile out(path);
+	if (out.open(QFile::WriteOnly | QIODevice::Text)) {
+		for (const QString& board : std::as_const(boards)) {
+			out.write(board.toUtf8() + '\n');
+		}
+		out.commit();
+	}
+
+	return letters;
+}
+
+//-----------------------------------------------------------------------------
+
+void Generator::pruneCache() const
+{
+	// Keep the loaded word list and the most recently used others, and remove caches in older formats
+	const QString loaded = QString::fromLatin1(m_words_hash);
+	QStringList kept(loaded);
+	const QFileInfoList files = QDir(m_cache_path).entryInfoList(QDir::Files, QDir::Time);
+	for (const QFileInfo& file : files) {
+		if (file.fileName().startsWith("boards-") || (file.fileName() == loaded)) {
+			continue;
+		}
+		if ((kept.count() < cache_limit) && Trie::isCache(file.filePath())) {
+			kept.append(file.fileName());
+		} else {
+			QFile::remove(file.filePath());
+		}
+	}
+
+	// Remove pools of boards for word lists that are no longer cached
+	for (const QFileInfo& file : files) {
+		const QString name = file.fileName();
+		if (name.startsWith("boards-") && !kept.contains(name.section('-', 1, 1))) {
+			QFile::remove(file.filePath());
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
 
-			// Restart if still stuck at local minimum
-			if (loops == m_size) {
-				current.roll();
-				loops = 0;
+void Generator::refillPool(const QString& path, const Search& details)
+{
+	m_refill_stopped.store(false, std::memory_order_relaxed);
+	const quint64 seed = m_random.generate64();
+	const int density = m_density;
+	m_refill_pool.start([this, path, details, density, seed] {
+		// Count boards in pool
+		int count = 0;
+		QFile file(path);
+		if (file.open(QFile::ReadOnly | QIODevice::Text)) {
+			QTextStream stream(&file);
+			while (!stream.atEnd()) {
+				if (!stream.readLine().isEmpty()) {
+					++count;
+				}
 			}
+			file.close();
 		}
-	} while (!m_canceled.load(std::memory_order_relaxed) && (current.delta() > words_range));
 
-	// Store solutions for generated board
-	m_letters = current.letters();
-	solver.setTrackPositions(true);
-	solver.solve(m_letters);
-	m_max_score = solver.score(m_max_words);
-	m_solutions = solver.solutions();
+		// Add boards until pool is full
+		Random random(seed);
+		for (; count < pool_size; ++count) {
+			const quint64 board_seed = searchSeed(random, density, details.strategy);
+			const QStringList letters = search(details, board_seed, m_refill_stopped);
+			if (letters.isEmpty() || !file.open(QFile::WriteOnly | QFile::Append | QIODevice::Text)) {
+				break;
+			}
+			file.write(QByteArray::number(board_seed) + ' ' + letters.join(',').toUtf8() + '\n');
+			file.close();
+		}
+	});
+}
+
+//-----------------------------------------------------------------------------
+
+void Generator::stopRefill()
+{
+	m_refill_stopped.store(true, std::memory_order_relaxed);
+	m_refill_pool.waitForDone();
 }
 
 //-----------------------------------------------------------------------------
@@ -261,53 +649,89 @@ void Generator::update()
 	QString dice_path = settings.dice();
 	if (dice_path != m_dice_path) {
 		m_dice_path.clear();
+		m_dice_hash.clear();
 		m_dice.clear();
-		m_dice_large.clear();
 
+		// Read sets of dice, which are separated by blank lines
 		QList<QStringList> dice;
+		QCryptographicHash hash(QCryptographicHash::Sha1);
 		QFile file(dice_path);
 		if (file.open(QFile::ReadOnly | QIODevice::Text)) {
 			QTextStream stream(&file);
 			while (!stream.atEnd()) {
-				const QStringList line = stream.readLine().split(',', Qt::SkipEmptyParts);
+				const QString text = stream.readLine();
+				hash.addData(text.toUtf8());
+				if (text.trimmed().isEmpty()) {
+					if (!dice.isEmpty()) {
+						m_dice.insert(dice.count(), dice);
+						dice.clear();
+					}
+					continue;
+				}
+
+				const QStringList line = text.split(',', Qt::SkipEmptyParts);
 				if (line.count() == 6) {
 					dice.append(line);
 				}
 			}
+			if (!dice.isEmpty()) {
+				m_dice.insert(dice.count(), dice);
+			}
 			file.close();
 		}
 
-		if (dice.count() == 41) {
+		// Split dice files without blank lines into normal and large sets
+		if ((m_dice.count() == 1) && m_dice.contains(41)) {
+			dice = m_dice.take(41);
+			m_dice.insert(16, dice.mid(0, 16));
+			m_dice.insert(25, dice.mid(16));
+		}
+
+		if (m_dice.contains(16) && m_dice.contains(25)) {
 			m_dice_path = dice_path;
-			m_dice = dice.mid(0, 16);
-			m_dice_large = dice.mid(16);
+			m_dice_hash = hash.result().toHex();
 		} else {
-			m_dice = m_dice_large = QList<QStringList>() << QStringList("?");
+			m_dice.clear();
 			return setError(tr("Unable to read dice from file."));
 		}
 	}
 
-	// Load words
-	QString words_path = settings.words();
-	if (words_path != m_words_path) {
+	// Load words, identified by their contents so that imported games reusing a path are reloaded,
+	// and only hash the contents again if the file has changed
+	const QString words_path = settings.words();
+	const QFileInfo words_info(words_path);
+	QByteArray words_hash = m_words_hash;
+	if ((words_path != m_words_path)
+			|| (words_info.size() != m_words_size)
+			|| (words_info.lastModified() != m_words_modified)) {
+		words_hash.clear();
+		QFile words_file(words_path);
+		if (words_file.open(QFile::ReadOnly)) {
+			QCryptographicHash hash(QCryptographicHash::Sha1);
+			if (hash.addData(&words_file)) {
+				words_hash = hash.result().toHex();
+			}
+			words_file.close();
+		}
+	}
+	if (words_hash.isEmpty()) {
 		m_words_path.clear();
+		m_words_hash.clear();
+		m_words.clear();
+		return setError(tr("Unable to read word list from file."));
+	}
+
+	if (words_hash != m_words_hash) {
+		m_words_hash.clear();
 		m_words.clear();
 
-		// Load cached words
-		constexpr quint32 TANGLET_CACHE_MAGICNUMBER = 0x54524945;
-		constexpr quint32 TANGLET_CACHE_VERSION = 2;
-		QString cache_file = QCryptographicHash::hash(words_path.toUtf8(), QCryptographicHash::Sha1).toHex();
-		QFileInfo cache_info(m_cache_path + "/" + cache_file);
-		if (cache_info.exists() && (cache_info.lastModified() > QFileInfo(words_path).lastModified())) {
-			QFile file(cache_info.absoluteFilePath());
-			if (file.open(QFile::ReadOnly)) {
-				QDataStream stream(&file);
-				quint32 magic, version;
-				stream >> magic >> version;
-				if ((magic == TANGLET_CACHE_MAGICNUMBER) && (version == TANGLET_CACHE_VERSION)) {
-					stream.setVersion(QDataStream::Qt_5_9);
-					stream >> m_words;
-				}
+		// Load cached words, and mark them as recently used; changing the time of a file needs
+		// write access on some platforms, and pruneCache() keeps the loaded words if it fails
+		const QString cache_file = m_cache_path + "/" + QString::fromLatin1(words_hash);
+		if (m_words.load(cache_file)) {
+			QFile file(cache_file);
+			if (file.open(QFile::ReadWrite | QFile::ExistingOnly)) {
+				file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
 				file.close();
 			}
 		}
@@ -316,31 +740,28 @@ void Generator::update()
 		if (m_words.isEmpty()) {
 			Q_EMIT optimizingStarted();
 
-			m_words = Trie(gunzip(words_path));
+			m_words.build(words_path);
 
 			// Cache words
 			if (!m_words.isEmpty()) {
 				QDir::home().mkpath(m_cache_path);
-				QFile file(cache_info.absoluteFilePath());
-				if (file.open(QFile::WriteOnly)) {
-					QDataStream stream(&file);
-					stream << TANGLET_CACHE_MAGICNUMBER;
-					stream << TANGLET_CACHE_VERSION;
-					stream.setVersion(QDataStream::Qt_5_9);
-					stream << m_words;
-					file.close();
-				}
+				m_words.save(cache_file);
 			}
 
 			Q_EMIT optimizingFinished();
 		}
 
 		if (!m_words.isEmpty()) {
-			m_words_path = words_path;
+			m_words_hash = words_hash;
+			pruneCache();
 		} else {
 			return setError(tr("Unable to read word list from file."));
 		}
 	}
+
+	m_words_path = words_path;
+	m_words_size = words_info.size();
+	m_words_modified = words_info.lastModified();
 }
 
 //-----------------------------------------------------------------------------
@@ -349,7 +770,7 @@ void Generator::setError(const QString& error)
 {
 	m_error = error;
 	m_letters.clear();
-	int count = m_size * m_size;
+	int count = m_width * m_height;
 	for (int i = 0; i < count; ++i) {
 		m_letters.append("?");
 	}
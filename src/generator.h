@@ -7,14 +7,16 @@
 #ifndef TANGLET_GENERATOR_H
 #define TANGLET_GENERATOR_H
 
+#include "random.h"
 #include "trie.h"
 
+#include <QDateTime>
 #include <QHash>
 #include <QList>
 #include <QPoint>
-#include <QRandomGenerator>
 #include <QStringList>
 #include <QThread>
+#include <QThreadPool>
 
 #include <atomic>
 
@@ -26,12 +28,26 @@ class Generator : public QThread
 	Q_OBJECT
 
 public:
+	/**
+	 * How boards are searched for.
+	 */
+	enum Strategy
+	{
+		HillClimbing, /**< only accept better boards, and restart when stuck */
+		Annealing /**< accept worse boards with a chance that shrinks as the search cools */
+	};
+
 	/**
 	 * Constructs a generator instance.
 	 * @param parent the QObject that manages the generator
 	 */
 	explicit Generator(QObject* parent = nullptr);
 
+	/**
+	 * Stops refilling the board pool.
+	 */
+	~Generator();
+
 	/**
 	 * Aborts the current game generation.
 	 */
@@ -40,12 +56,15 @@ public:
 	/**
 	 * Creates and solves the game layout.
 	 * @param density how many words are in the layout
-	 * @param size how big the layout is
+	 * @param width how many cells wide is the layout
+	 * @param height how many cells tall is the layout
 	 * @param minimum the shortest word allowed
 	 * @param timer the game mode used to determine the maximum amount of words
 	 * @param letters an already built layout to solve instead of create
+	 * @param seed the seed of a previous board to replay instead of taking a new board, or @c 0;
+	 * a replayed board is found with the density and strategy stored in its seed
 	 */
-	void create(int density, int size, int minimum, int timer, const QStringList& letters);
+	void create(int density, int width, int height, int minimum, int timer, const QStringList& letters, quint64 seed = 0);
 
 	/**
 	 * Fetch the dice for a given board size.
@@ -54,9 +73,18 @@ public:
 	 */
 	QList<QStringList> dice(int size) const
 	{
-		return (size == 4) ? m_dice : m_dice_large;
+		return dice(size, size);
 	}
 
+	/**
+	 * Fetch the dice for a given board size. If there is no set with one die for each cell, the
+	 * dice are taken from the next larger set, or repeated from the largest set.
+	 * @param width how many cells wide is the board
+	 * @param height how many cells tall is the board
+	 * @return list of dice
+	 */
+	QList<QStringList> dice(int width, int height) const;
+
 	/**
 	 * @return the dictionary site to look up word definitions
 	 */
@@ -114,11 +142,30 @@ public:
 	}
 
 	/**
-	 * @return size of generated board
+	 * Fetches the seed of the search that found the board. The seed stores the density as its
+	 * remainder when divided by 3, and the strategy in the next bit, so searching again with the
+	 * same seed, word list, dice, size, and minimum word length finds the same board.
+	 * @return seed of generated board
 	 */
-	int size() const
+	quint64 seed() const
 	{
-		return m_size;
+		return m_seed;
+	}
+
+	/**
+	 * @return how many cells wide is the generated board
+	 */
+	int width() const
+	{
+		return m_width;
+	}
+
+	/**
+	 * @return how many cells tall is the generated board
+	 */
+	int height() const
+	{
+		return m_height;
 	}
 
 	/**
@@ -138,6 +185,16 @@ public:
 		m_cache_path = path;
 	}
 
+	/**
+	 * Sets how boards are searched for. Boards are hill climbed by default. Takes effect on the
+	 * next call to create().
+	 * @param strategy the search strategy
+	 */
+	static void setStrategy(Strategy strategy)
+	{
+		m_default_strategy = strategy;
+	}
+
 Q_SIGNALS:
 	/**
 	 * Emitted when the word list is being optimized for fast access.
@@ -150,6 +207,21 @@ Q_SIGNALS:
 	void optimizingFinished();
 
 private:
+	/**
+	 * The details of a board to search for, copied so that searches never read the generator.
+	 */
+	struct Search
+	{
+		Trie words; /**< the words to find on the board */
+		QList<QStringList> dice; /**< the dice used to fill the board */
+		int width; /**< how many letters wide to make the board */
+		int height; /**< how many letters tall to make the board */
+		int minimum; /**< the shortest word allowed */
+		Strategy strategy; /**< how the board is searched for */
+		int target; /**< the target amount of words */
+		int range; /**< how far off the target amount of words a board can be */
+	};
+
 	/**
 	 * Loads the dice and words.
 	 */
@@ -161,6 +233,48 @@ private:
 	 */
 	void setError(const QString& error);
 
+	/**
+	 * Searches for a board by changing dice until the board has close to the target amount of
+	 * words. Several searches run at once, and all of them stop when one finds a board.
+	 * @param details the board to search for
+	 * @param seed the seed of the random number generator of this search
+	 * @param found set by the first search to find a board, and checked by the others
+	 * @return the board layout, or an empty list if the search was stopped first
+	 */
+	QStringList search(const Search& details, quint64 seed, std::atomic<bool>& found) const;
+
+	/**
+	 * @return location of the pool of boards for the current word list, dice, size, density,
+	 * minimum word length, and search strategy
+	 */
+	QString poolPath() const;
+
+	/**
+	 * Removes the first valid board from a pool of boards, along with any invalid boards before it.
+	 * @param path location of the pool
+	 * @param[out] seed set to the seed of the search that found the board
+	 * @return the board layout, or an empty list if the pool has no valid boards
+	 */
+	QStringList takePooledBoard(const QString& path, quint64& seed) const;
+
+	/**
+	 * Removes cached word lists other than the loaded one and the most recently used others, along
+	 * with their pools of boards, and caches in older formats.
+	 */
+	void pruneCache() const;
+
+	/**
+	 * Searches for boards in a low priority thread until the pool is full again.
+	 * @param path location of the pool
+	 * @param details the boards to search for
+	 */
+	void refillPool(const QString& path, const Search& details);
+
+	/**
+	 * Stops refilling the pool of boards and waits for the thread to finish.
+	 */
+	void stopRefill();
+
 protected:
 	/**
 	 * Builds the game layout in a thread.
@@ -169,27 +283,37 @@ protected:
 
 private:
 	static QString m_cache_path; /**< where to find cached tries */
+	static Strategy m_default_strategy; /**< how new generators search for boards */
 
 	QString m_dice_path; /**< where to load the dice */
-	QString m_words_path; /**< where to load the word list */
+	QByteArray m_dice_hash; /**< hash of the contents of the loaded dice */
+	QString m_words_path; /**< where the hashed word list was loaded from */
+	qint64 m_words_size; /**< how many bytes were in the hashed word list */
+	QDateTime m_words_modified; /**< when the hashed word list was last modified */
+	QByteArray m_words_hash; /**< hash of the contents of the loaded word list */
 	QString m_dictionary_url; /**< where to look up word definitions */
-	QList<QStringList> m_dice; /**< the dice used to generate a normal board */
-	QList<QStringList> m_dice_large; /**< the dice used to generate a large board */
-	QRandomGenerator m_random; /**< the random number generator */
+	QHash<int, QList<QStringList>> m_dice; /**< sets of dice used to generate boards keyed by how many dice are in them */
+	Random m_random; /**< the random number generator used to seed searches */
 	Trie m_words; /**< the word list optimized for solving */
 	QString m_error; /**< error encountered while loading dice and words */
 
+	Strategy m_strategy; /**< how boards are searched for */
 	int m_density; /**< how many words to target */
-	int m_size; /**< how many letters wide to make the board */
+	int m_width; /**< how many letters wide to make the board */
+	int m_height; /**< how many letters tall to make the board */
 	int m_minimum; /**< the shortest word allowed */
 	int m_timer; /**< the timer mode for the generated board */
 	int m_max_words; /**< the maximum number of words used to generate maximum score */
 	int m_max_score; /**< the maximum score found on generated board */
+	quint64 m_seed; /**< the seed of the search that found the generated board */
 
 	QStringList m_letters; /**< the generated layout */
 	QHash<QString, QList<QList<QPoint>>> m_solutions; /**< the available words and their locations */
 
 	std::atomic<bool> m_canceled; /**< if the generation has been aborted by player */
+
+	QThreadPool m_refill_pool; /**< low priority thread used to refill the pool of boards */
+	std::atomic<bool> m_refill_stopped; /**< if refilling the pool of boards has been stopped */
 };
 
 #endif // TANGLET_GENERATOR_H
@@ -39,25 +39,33 @@ void gzip(const QString& path)
 QByteArray gunzip(const QString& path)
 {
 	QByteArray data;
+	gunzip(path, [&data](const QByteArray& chunk) {
+		data.append(chunk);
+	});
+	return data;
+}
+
+//-----------------------------------------------------------------------------
 
+bool gunzip(const QString& path, const std::function<void(const QByteArray&)>& process)
+{
 	QFile file(path);
 	if (!file.open(QFile::ReadOnly)) {
-		return data;
+		return false;
 	}
 	gzFile gz = gzdopen(file.handle(), "rb");
 	if (!gz) {
-		return data;
+		return false;
 	}
 
 	QByteArray buffer(0x40000, 0);
 	int read = 0;
-	do {
-		data.append(buffer.constData(), read);
-		read = gzread(gz, buffer.data(), buffer.size());
-	} while (read > 0);
+	while ((read = gzread(gz, buffer.data(), buffer.size())) > 0) {
+		process(QByteArray::fromRawData(buffer.constData(), read));
+	}
 	gzclose(gz);
 
-	return data;
+	return read == 0;
 }
 
 //-----------------------------------------------------------------------------
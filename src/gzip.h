@@ -7,6 +7,8 @@
 #ifndef TANGLET_GZIP_H
 #define TANGLET_GZIP_H
 
+#include <functional>
+
 class QByteArray;
 class QString;
 
@@ -23,4 +25,12 @@ void gzip(const QString& path);
  */
 QByteArray gunzip(const QString& path);
 
+/**
+ * Decompress the file located at path with the Gzip algorithm one chunk at a time.
+ * @param path file to decompress
+ * @param process function called with each chunk of uncompressed contents
+ * @return @c true if the whole file was decompressed
+ */
+bool gunzip(const QString& path, const std::function<void(const QByteArray&)>& process);
+
 #endif // TANGLET_GZIP_H
@@ -11,6 +11,7 @@
 #include "window.h"
 
 #include <QApplication>
+#include <QCommandLineOption>
 #include <QCommandLineParser>
 #include <QDir>
 #include <QFileInfo>
@@ -55,6 +56,8 @@ int main(int argc, char** argv)
 	parser.setApplicationDescription(QCoreApplication::translate("main", "Word finding game"));
 	parser.addHelpOption();
 	parser.addVersionOption();
+	parser.addOption(QCommandLineOption("anneal", QCoreApplication::translate("main", "Search for new boards with simulated annealing.")));
+	parser.addOption(QCommandLineOption("seed", QCoreApplication::translate("main", "Replay the board found with <seed>, using the new game settings."), "seed"));
 	parser.addPositionalArgument("file", QCoreApplication::translate("main", "A game file to play."), "[file]");
 	parser.process(app);
 
@@ -68,6 +71,11 @@ int main(int argc, char** argv)
 	}
 	Generator::setTriePath(userdir + "/Trie");
 
+	// Set how to search for new boards
+	if (parser.isSet("anneal")) {
+		Generator::setStrategy(Generator::Annealing);
+	}
+
 	// Set where to store imported games
 	Window::setDataPath(userdir);
 
@@ -79,7 +87,7 @@ int main(int argc, char** argv)
 
 	// Create main window
 	QStringList files = parser.positionalArguments();
-	Window window(files.isEmpty() ? QString() : files.front());
+	Window window(files.isEmpty() ? QString() : files.front(), parser.value("seed").toULongLong());
 	window.show();
 
 	return app.exec();
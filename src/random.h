@@ -0,0 +1,125 @@
+/*
+	SPDX-FileCopyrightText: 2026 Graeme Gott <graeme@gottcode.org>
+
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#ifndef TANGLET_RANDOM_H
+#define TANGLET_RANDOM_H
+
+#include <QtGlobal>
+
+#include <limits>
+
+/**
+ * @brief The Random class is a fast random number generator for searching for boards.
+ *
+ * It uses the xoshiro256** algorithm, which is not suitable for cryptography but is much faster
+ * than QRandomGenerator. The same seed always produces the same numbers, so a search can be
+ * replayed exactly as long as it only uses these methods: the standard algorithms, such as
+ * std::shuffle(), consume numbers differently in each standard library.
+ */
+class Random
+{
+public:
+	typedef quint64 result_type;
+
+	/**
+	 * Constructs a random number generator instance.
+	 * @param seed the value that determines every number generated
+	 */
+	explicit Random(quint64 seed)
+	{
+		// Spread the seed over the state with splitmix64, which never leaves the state all zero
+		for (quint64& state : m_state) {
+			seed += Q_UINT64_C(0x9e3779b97f4a7c15);
+			quint64 z = seed;
+			z = (z ^ (z >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+			z = (z ^ (z >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+			state = z ^ (z >> 31);
+		}
+	}
+
+	/**
+	 * Generates a random number below a limit.
+	 * @param bound the upper limit, which is never returned
+	 * @return a random number in the range [0, @p bound)
+	 */
+	quint32 bounded(quint32 bound)
+	{
+		return (quint64(generate()) * bound) >> 32;
+	}
+
+	/**
+	 * @return a random 32-bit number
+	 */
+	quint32 generate()
+	{
+		return generate64() >> 32;
+	}
+
+	/**
+	 * @return a random 64-bit number
+	 */
+	quint64 generate64()
+	{
+		const quint64 result = rotate(m_state[1] * 5, 7) * 9;
+		const quint64 t = m_state[1] << 17;
+		m_state[2] ^= m_state[0];
+		m_state[3] ^= m_state[1];
+		m_state[1] ^= m_state[2];
+		m_state[0] ^= m_state[3];
+		m_state[2] ^= t;
+		m_state[3] = rotate(m_state[3], 45);
+		return result;
+	}
+
+	/**
+	 * @return a random number in the range [0, 1)
+	 */
+	double generateDouble()
+	{
+		return (generate64() >> 11) * (1.0 / (Q_UINT64_C(1) << 53));
+	}
+
+	/**
+	 * @return a random 64-bit number
+	 */
+	quint64 operator()()
+	{
+		return generate64();
+	}
+
+	/**
+	 * @return the smallest number generated
+	 */
+	static constexpr quint64 min()
+	{
+		return std::numeric_limits<quint64>::min();
+	}
+
+	/**
+	 * @return the largest number generated
+	 */
+	static constexpr quint64 max()
+	{
+		return std::numeric_limits<quint64>::max();
+	}
+
+private:
+	/**
+	 * Rotates the bits of a number to the left.
+	 * @param value the number to rotate
+	 * @param bits how far to rotate
+	 * @return the rotated number
+	 */
+	static quint64 rotate(quint64 value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+private:
+	quint64 m_state[4]; /**< the state of the generator */
+};
+
+#endif // TANGLET_RANDOM_H
@@ -6,87 +6,250 @@
 
 #include "solver.h"
 
+#include <QSet>
 #include <QStringList>
+#include <QThreadPool>
 
 #include <algorithm>
 #include <functional>
 
 //-----------------------------------------------------------------------------
 
+namespace
+{
+
+/**
+ * The score for a word.
+ * @param length how many letters are in the word
+ * @return how many points the word is worth
+ */
+int scoreLength(int length)
+{
+	static constexpr int scores[9] = {
+		 0,  0,  0,  1,  1,  2,  3,  5, 11
+	};
+	return scores[std::min(length, 8)];
+}
+
+constexpr int transition_count = 256; /**< how many walks are cached for each face */
+
+}
+
+//-----------------------------------------------------------------------------
+
 Solver::Solver(const Trie& words, int size, int minimum)
+	: Solver(words, size, size, minimum)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+Solver::Solver(const Trie& words, int width, int height, int minimum)
 	: m_words(&words)
-	, m_node(words.child())
-	, m_size(size)
+	, m_width(width)
+	, m_height(height)
 	, m_minimum(minimum)
 	, m_track_positions(true)
+	, m_depth(0)
+	, m_paths(nullptr)
+	, m_generation(0)
 	, m_count(0)
+	, m_thread_count(1)
+	, m_record_words(false)
 {
-	// Create neighbors
-	QList<QList<QPoint>> neighbors;
-	const QPoint deltas[] = {
-		QPoint(-1, -1),
-		QPoint(0, -1),
-		QPoint(1, -1),
-		QPoint(-1, 0),
-		QPoint(1, 0),
-		QPoint(-1, 1),
-		QPoint(0, 1),
-		QPoint(1, 1)
-	};
-	for (int r = 0; r < m_size; ++r) {
-		for (int c = 0; c < m_size; ++c) {
-			QList<QPoint> positions;
-			QPoint pos(c, r);
-			for (int i = 0; i < 8; ++i) {
-				QPoint n = pos + deltas[i];
-				if (n.x() > -1 && n.x() < m_size && n.y() > -1 && n.y() < m_size) {
-					positions.append(n);
+	Q_ASSERT(m_width > 0 && m_height > 0 && (m_width * m_height) <= 64);
+
+	// Create cells; a word can use each cell once
+	const int count = m_width * m_height;
+	m_cells.resize(count);
+	m_neighbors.resize(count);
+	m_stack.resize(count);
+	for (int r = 0; r < m_height; ++r) {
+		for (int c = 0; c < m_width; ++c) {
+			const int index = (r * m_width) + c;
+			m_cells[index].position = QPoint(c, r);
+
+			// Find neighbors of cell
+			quint64 mask = 0;
+			for (int dr = -1; dr <= 1; ++dr) {
+				for (int dc = -1; dc <= 1; ++dc) {
+					const int nr = r + dr;
+					const int nc = c + dc;
+					if ((dr || dc) && (nr > -1) && (nr < m_height) && (nc > -1) && (nc < m_width)) {
+						mask |= quint64(1) << ((nr * m_width) + nc);
+					}
 				}
 			}
-			neighbors.append(positions);
+			m_neighbors[index] = mask;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+Solver::~Solver()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void Solver::solve(const QStringList& letters)
+{
+	clearSolutions();
+	setLetters(letters);
+	if (m_thread_count > 1) {
+		searchParallel(letters, m_track_positions);
+	} else if (m_track_positions) {
+		search<true>();
+	} else {
+		search<false>();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+int Solver::countWords(const QStringList& letters)
+{
+	clearSolutions();
+	setLetters(letters);
+	if (m_thread_count > 1) {
+		searchParallel(letters, false);
+	} else {
+		search<false>();
+	}
+	return m_count;
+}
+
+//-----------------------------------------------------------------------------
+
+int Solver::countWords(const QStringList& letters, const Paths& previous, Paths& paths)
+{
+	Q_ASSERT(&previous != &paths);
+
+	clearSolutions();
+	setLetters(letters);
+
+	// Find the cells that have changed since the paths were found
+	const int count = m_cells.count();
+	const quint64 all = ~quint64(0) >> (64 - count);
+	quint64 changed = 0;
+	if (previous.m_letters.count() != count) {
+		changed = all;
+	} else {
+		for (int i = 0; i < count; ++i) {
+			if (letters.at(i) != previous.m_letters.at(i)) {
+				changed |= quint64(1) << i;
+			}
 		}
 	}
 
-	// Create cells
-	m_cells = QList<QList<Cell>>(m_size, QList<Cell>(m_size));
-	for (int r = 0; r < m_size; ++r) {
-		for (int c = 0; c < m_size; ++c) {
-			int index = (r * m_size) + c;
-			Cell& cell = m_cells[c][r];
-			cell.position = QPoint(c, r);
-			cell.checked = false;
+	// Copy letters one at a time so that the lists never share data and detach later
+	paths.m_letters.resize(count);
+	for (int i = 0; i < count; ++i) {
+		paths.m_letters[i] = letters.at(i);
+	}
+
+	startSearch();
+	paths.m_paths.clear();
+	m_paths = &paths.m_paths;
 
-			const auto& n = neighbors.at(index);
-			for (int i = 0; i < n.count(); ++i) {
-				const QPoint& neighbor = n.at(i);
-				cell.neighbors.append(&m_cells[neighbor.x()][neighbor.y()]);
+	// Keep the paths that do not use a changed cell
+	if (changed != all) {
+		for (const Path& path : std::as_const(previous.m_paths)) {
+			if (path.visited & changed) {
+				continue;
+			}
+			m_paths->append(path);
+			if (path.node->isWord() && (path.length >= m_minimum)) {
+				addWord(path.word);
 			}
 		}
 	}
+
+	// Search for paths that step from a kept path into a changed cell
+	const qsizetype kept = m_paths->count();
+	for (qsizetype i = 0; i < kept; ++i) {
+		const Path path = m_paths->at(i);
+		const quint64 next = m_neighbors.at(path.cell) & changed & ~path.visited;
+		if (!next || path.node->isEmpty()) {
+			continue;
+		}
+
+		Frame& frame = m_stack[0];
+		frame.cell = path.cell;
+		frame.node = path.node;
+		frame.visited = path.visited;
+		frame.next = next;
+		frame.word = path.word;
+		frame.length = path.length;
+		m_depth = 1;
+		searchStack<false, true>(0);
+	}
+
+	// Search for paths that start in a changed cell
+	for (quint64 next = changed; next; next &= next - 1) {
+		checkCell<false, true>(qCountTrailingZeroBits(next));
+		searchStack<false, true>(0);
+	}
+
+	m_paths = nullptr;
+	return m_count;
 }
 
 //-----------------------------------------------------------------------------
 
-void Solver::solve(const QStringList& letters)
+QHash<QString, QList<QList<QPoint>>> Solver::solutions() const
 {
-	m_solutions.clear();
-	m_positions.clear();
-	m_word.clear();
-	m_count = 0;
+	QHash<QString, QList<QList<QPoint>>> solutions;
+	solutions.reserve(m_solution_lengths.count());
 
-	// Set cell contents
-	for (int r = 0; r < m_size; ++r) {
-		for (int c = 0; c < m_size; ++c) {
-			m_cells[c][r].text = letters.at((r * m_size) + c).toUpper();
+	const qsizetype count = m_solution_words.count();
+	for (qsizetype i = 0; i < count; ++i) {
+		const qsizetype start = m_solution_offsets.at(i);
+		const qsizetype end = m_solution_offsets.at(i + 1);
+		QString word;
+		QList<QPoint> positions;
+		positions.reserve(end - start);
+		for (qsizetype j = start; j < end; ++j) {
+			const Cell& cell = m_cells.at(m_solution_cells.at(j));
+			word += m_faces.at(cell.face).text;
+			positions.append(cell.position);
 		}
+		solutions[word].append(positions);
 	}
 
-	// Solve board
-	for (int r = 0; r < m_size; ++r) {
-		for (int c = 0; c < m_size; ++c) {
-			checkCell(m_cells[c][r]);
+	return solutions;
+}
+
+//-----------------------------------------------------------------------------
+
+QStringList Solver::words() const
+{
+	QStringList words;
+	words.reserve(m_solution_lengths.count());
+
+	// Only build the text of the first path of each word
+	QSet<quint32> found;
+	found.reserve(m_solution_lengths.count());
+
+	const qsizetype count = m_solution_words.count();
+	for (qsizetype i = 0; i < count; ++i) {
+		const quint32 number = m_solution_words.at(i);
+		if (found.contains(number)) {
+			continue;
 		}
+		found.insert(number);
+
+		QString word;
+		const qsizetype end = m_solution_offsets.at(i + 1);
+		for (qsizetype j = m_solution_offsets.at(i); j < end; ++j) {
+			word += m_faces.at(m_cells.at(m_solution_cells.at(j)).face).text;
+		}
+		words.append(word);
 	}
+
+	std::sort(words.begin(), words.end());
+	return words;
 }
 
 //-----------------------------------------------------------------------------
@@ -94,9 +257,9 @@ void Solver::solve(const QStringList& letters)
 int Solver::score(int max) const
 {
 	QList<int> scores;
-	QHashIterator<QString, QList<QList<QPoint>>> i(m_solutions);
-	while (i.hasNext()) {
-		scores += score(i.next().key());
+	scores.reserve(m_solution_lengths.count());
+	for (int length : m_solution_lengths) {
+		scores += scoreLength(length);
 	}
 	std::sort(scores.begin(), scores.end(), std::greater<int>());
 
@@ -115,12 +278,7 @@ int Solver::score(int max) const
 
 int Solver::score(const QString& word)
 {
-	Q_ASSERT(word.length() <= 25);
-	static constexpr int scores[26] = {
-		 0,  0,  0,  1,  1,  2,  3,  5, 11, 11, 11, 11, 11,
-		11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11
-	};
-	return scores[word.length()];
+	return scoreLength(word.length());
 }
 
 //-----------------------------------------------------------------------------
@@ -132,46 +290,283 @@ void Solver::setTrackPositions(bool track_positions)
 
 //-----------------------------------------------------------------------------
 
-void Solver::checkCell(Cell& cell)
+void Solver::setThreadCount(int count)
 {
-	const Trie::Node* node = m_node;
-	int length = cell.text.length();
-	for (int i = 0; i < length; ++i) {
-		node = m_words->child(cell.text.at(i), node);
-		if (!node) {
-			return;
+	m_thread_count = std::max(1, count);
+}
+
+//-----------------------------------------------------------------------------
+
+void Solver::setLetters(const QStringList& letters)
+{
+	const int count = m_cells.count();
+	for (int i = 0; i < count; ++i) {
+		Cell& cell = m_cells[i];
+		if (!cell.letter.isNull() && (cell.letter == letters.at(i))) {
+			continue;
 		}
+
+		cell.letter = letters.at(i);
+		cell.face = face(cell.letter);
+		const Face& face = m_faces.at(cell.face);
+		cell.code = (face.codes.count() == 1) ? face.codes.constFirst() : -1;
+		cell.length = face.text.length();
 	}
+}
+
+//-----------------------------------------------------------------------------
 
-	cell.checked = true;
-	m_word += cell.text;
-	if (m_track_positions) {
-		m_positions.append(cell.position);
+int Solver::face(const QString& letter)
+{
+	const auto i = m_face_indexes.constFind(letter);
+	if (i != m_face_indexes.constEnd()) {
+		return *i;
 	}
-	qSwap(m_node, node);
 
-	if (m_node->isWord() && (m_word.length() >= m_minimum)) {
-		m_count++;
-		if (m_track_positions) {
-			m_solutions[m_word].append(m_positions);
+	Face face;
+	face.text = letter.toUpper();
+	for (const QChar& c : std::as_const(face.text)) {
+		face.codes.append(m_words->code(c));
+	}
+	if (face.codes.count() != 1) {
+		face.transitions.fill(Transition{ nullptr, nullptr, 0 }, transition_count);
+	}
+
+	const int index = m_faces.count();
+	m_faces.append(face);
+	m_face_indexes.insert(letter, index);
+	return index;
+}
+
+//-----------------------------------------------------------------------------
+
+const Trie::Node* Solver::walk(Face& face, const Trie::Node* node, quint32& word) const
+{
+	Transition& transition = face.transitions[(node - m_words->child()) & (transition_count - 1)];
+	if (transition.from != node) {
+		transition.from = node;
+		transition.to = node;
+		transition.word = 0;
+		for (int code : std::as_const(face.codes)) {
+			const Trie::Node* next = m_words->child(code, node);
+			if (!next) {
+				transition.to = nullptr;
+				break;
+			}
+			transition.word += node->isWord() + m_words->wordOffset(next);
+			transition.to = node = next;
 		}
 	}
-	if (!m_node->isEmpty()) {
-		int count = cell.neighbors.count();
+	word += transition.word;
+	return transition.to;
+}
+
+//-----------------------------------------------------------------------------
+
+void Solver::startSearch()
+{
+	m_depth = 0;
+	m_count = 0;
+
+	// Start a new generation of found words
+	if (m_stamps.count() != qsizetype(m_words->wordCount())) {
+		m_stamps.fill(0, m_words->wordCount());
+		m_generation = 0;
+	}
+	++m_generation;
+	if (!m_generation) {
+		m_stamps.fill(0);
+		m_generation = 1;
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Solver::searchParallel(const QStringList& letters, bool track_positions)
+{
+	// Search from every nth cell in each worker to spread out the corners and edges
+	const int count = std::min(m_thread_count, int(m_cells.count()));
+	while (m_workers.size() < size_t(count)) {
+		m_workers.push_back(std::make_unique<Solver>(*m_words, m_width, m_height, m_minimum));
+		m_workers.back()->m_record_words = true;
+	}
+	if (!m_pool) {
+		m_pool = std::make_unique<QThreadPool>();
+	}
+	m_pool->setMaxThreadCount(count);
+	for (int i = 0; i < count; ++i) {
+		Solver* worker = m_workers[i].get();
+		m_pool->start([worker, &letters, i, count, track_positions] {
+			worker->clearSolutions();
+			worker->setLetters(letters);
+			if (track_positions) {
+				worker->search<true>(i, count);
+			} else {
+				worker->search<false>(i, count);
+			}
+		});
+	}
+	m_pool->waitForDone();
+
+	// Only the different words of each worker are needed to count them
+	if (!track_positions) {
+		startSearch();
 		for (int i = 0; i < count; ++i) {
-			Cell& next = *cell.neighbors.at(i);
-			if (!next.checked) {
-				checkCell(next);
+			for (quint32 word : std::as_const(m_workers[i]->m_solution_words)) {
+				addWord(word);
 			}
 		}
+		return;
 	}
 
-	cell.checked = false;
-	m_word.chop(length);
-	if (m_track_positions) {
-		m_positions.removeLast();
+	// Merge paths in order of their first cell, which is the order of a single thread
+	startSearch();
+	std::vector<qsizetype> paths(count, 0);
+	const int cells = m_cells.count();
+	for (int i = 0; i < cells; ++i) {
+		const Solver* worker = m_workers[i % count].get();
+		qsizetype& path = paths[i % count];
+		for (const qsizetype end = worker->m_solution_words.count(); path < end; ++path) {
+			const qsizetype start = worker->m_solution_offsets.at(path);
+			if (worker->m_solution_cells.at(start) != i) {
+				break;
+			}
+
+			const quint32 word = worker->m_solution_words.at(path);
+			const bool added = addWord(word);
+
+			const qsizetype finish = worker->m_solution_offsets.at(path + 1);
+			int length = 0;
+			for (qsizetype j = start; j < finish; ++j) {
+				const quint8 cell = worker->m_solution_cells.at(j);
+				m_solution_cells.append(cell);
+				length += m_cells.at(cell).length;
+			}
+			m_solution_words.append(word);
+			m_solution_offsets.append(m_solution_cells.count());
+			if (added) {
+				m_solution_lengths.append(length);
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+template<bool TrackPositions>
+void Solver::search(int first, int step)
+{
+	startSearch();
+
+	const int count = m_cells.count();
+	for (int i = first; i < count; i += step) {
+		checkCell<TrackPositions, false>(i);
+		searchStack<TrackPositions, false>(0);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+template<bool TrackPositions, bool RecordPaths>
+void Solver::searchStack(int depth)
+{
+	while (m_depth > depth) {
+		Frame& frame = m_stack[m_depth - 1];
+		if (!frame.next) {
+			--m_depth;
+			continue;
+		}
+
+		// Visit unused neighbors in order of their index
+		const int next = qCountTrailingZeroBits(frame.next);
+		frame.next &= frame.next - 1;
+		checkCell<TrackPositions, RecordPaths>(next);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+template<bool TrackPositions, bool RecordPaths>
+void Solver::checkCell(int index)
+{
+	const Frame* parent = m_depth ? &m_stack.at(m_depth - 1) : nullptr;
+	const Cell& cell = m_cells.at(index);
+	const Trie::Node* node = parent ? parent->node : m_words->child();
+	quint32 word = parent ? parent->word : 0;
+	if (cell.length == 1) {
+		const Trie::Node* next = m_words->child(cell.code, node);
+		if (!next) {
+			return;
+		}
+		word += node->isWord() + m_words->wordOffset(next);
+		node = next;
+	} else {
+		node = walk(m_faces[cell.face], node, word);
+		if (!node) {
+			return;
+		}
+	}
+
+	Frame& frame = m_stack[m_depth];
+	frame.cell = index;
+	frame.node = node;
+	frame.visited = (parent ? parent->visited : 0) | (quint64(1) << index);
+	frame.next = node->isEmpty() ? 0 : (m_neighbors.at(index) & ~frame.visited);
+	frame.word = word;
+	frame.length = (parent ? parent->length : 0) + cell.length;
+	++m_depth;
+
+	if (RecordPaths) {
+		m_paths->append(Path{ node, frame.visited, word, index, frame.length });
+	}
+
+	if (node->isWord() && (frame.length >= m_minimum)) {
+		if (addWord(word)) {
+			if (TrackPositions) {
+				m_solution_lengths.append(frame.length);
+			} else if (m_record_words) {
+				m_solution_words.append(word);
+			}
+		}
+		if (TrackPositions) {
+			addSolution(word);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void Solver::clearSolutions()
+{
+	m_solution_words.clear();
+	m_solution_offsets.clear();
+	m_solution_offsets.append(0);
+	m_solution_cells.clear();
+	m_solution_lengths.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+bool Solver::addWord(quint32 word)
+{
+	quint32& stamp = m_stamps[word];
+	if (stamp == m_generation) {
+		return false;
+	}
+	stamp = m_generation;
+	m_count++;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void Solver::addSolution(quint32 word)
+{
+	m_solution_words.append(word);
+	for (int i = 0; i < m_depth; ++i) {
+		m_solution_cells.append(m_stack.at(i).cell);
 	}
-	m_node = node;
+	m_solution_offsets.append(m_solution_cells.count());
 }
 
 //-----------------------------------------------------------------------------
@@ -12,31 +12,121 @@
 #include <QHash>
 #include <QList>
 #include <QPoint>
+#include <QStringList>
+class QThreadPool;
+
+#include <memory>
+#include <vector>
 
 /**
  * @brief The Solver class finds all of the words on a board.
  */
 class Solver
 {
+	/**
+	 * @brief The Solver::Transition struct caches walking a face from a node.
+	 */
+	struct Transition
+	{
+		const Trie::Node* from; /**< node the walk started from */
+		const Trie::Node* to; /**< node of the last letter of the face, or @c nullptr if not found */
+		quint32 word; /**< how much the face adds to the number of the word */
+	};
+
+	/**
+	 * @brief The Solver::Face struct represents the text of a die resolved against the word list.
+	 */
+	struct Face
+	{
+		QString text; /**< text of the face */
+		QList<int> codes; /**< codes of the letters in the word list */
+		QList<Transition> transitions; /**< recent walks indexed by node; empty for single letters */
+	};
+
 	/**
 	 * @brief The Solver::Cell struct represents a letter on the board.
 	 */
 	struct Cell
 	{
-		QString text; /**< text of the letter */
-		QList<Cell*> neighbors; /**< which letters are connected to this one */
+		QString letter; /**< text of the letter as it was passed in */
+		int face; /**< index of the resolved face */
+		int code; /**< code of the letter in the word list if the face has only one */
+		int length; /**< how many letters are in the face */
 		QPoint position; /**< location on the board */
-		bool checked; /**< has it been used while building a word */
 	};
+
+	/**
+	 * @brief The Solver::Frame struct represents a cell of the word being assembled.
+	 */
+	struct Frame
+	{
+		int cell; /**< index of the cell */
+		const Trie::Node* node; /**< node of the last letter of the cell in the word list */
+		quint64 visited; /**< mask of the cells used by the word up to and including this one */
+		quint64 next; /**< mask of the neighbors that have not been checked yet */
+		quint32 word; /**< number of the word up to and including this cell in the word list */
+		int length; /**< how many letters are in the word up to and including this cell */
+	};
+
+	/**
+	 * @brief The Solver::Path struct represents cells on the board that spell the start of a word.
+	 */
+	struct Path
+	{
+		const Trie::Node* node; /**< node of the last letter of the path in the word list */
+		quint64 visited; /**< mask of the cells used by the path */
+		quint32 word; /**< number of the word up to the end of the path in the word list */
+		int cell; /**< index of the last cell of the path */
+		int length; /**< how many letters are in the path */
+	};
+
 public:
 	/**
-	 * Constructs a solver instance.
+	 * @brief The Solver::Paths class holds every path on a board that spells the start of a word.
+	 */
+	class Paths
+	{
+		friend class Solver;
+
+	public:
+		/**
+		 * Exchanges paths with another instance without copying them.
+		 * @param other the paths to exchange with
+		 */
+		void swap(Paths& other) noexcept
+		{
+			m_letters.swap(other.m_letters);
+			m_paths.swap(other.m_paths);
+		}
+
+	private:
+		QStringList m_letters; /**< board layout the paths were found on */
+		QList<Path> m_paths; /**< paths that spell the start of a word */
+	};
+
+public:
+	/**
+	 * Constructs a solver instance for a square board.
 	 * @param words the optimized word list
 	 * @param size the size of the board
 	 * @param minimum the shortest allowed word
 	 */
 	Solver(const Trie& words, int size, int minimum);
 
+	/**
+	 * Constructs a solver instance.
+	 * @param words the optimized word list
+	 * @param width how many cells wide is the board
+	 * @param height how many cells tall is the board
+	 * @param minimum the shortest allowed word
+	 */
+	Solver(const Trie& words, int width, int height, int minimum);
+
+	/**
+	 * Clean up solver.
+	 */
+	~Solver();
+
 	/**
 	 * Finds the solution to a board.
 	 * @param letters the board layout
@@ -44,7 +134,27 @@ public:
 	void solve(const QStringList& letters);
 
 	/**
-	 * @return how many words were found
+	 * Counts the words on a board without storing them. This is faster than solve() because it
+	 * only tracks how long each word is.
+	 * @param letters the board layout
+	 * @return how many different words were found
+	 */
+	int countWords(const QStringList& letters);
+
+	/**
+	 * Counts the words on a board by updating the paths found on a previous board. Only paths that
+	 * use a cell that has changed are searched, so this is much faster than countWords() when only
+	 * one or two cells differ. The previous paths are left alone so that the caller can return to
+	 * them, and the memory already held by @p paths is reused.
+	 * @param letters the board layout
+	 * @param previous the paths of the previous board
+	 * @param[out] paths replaced by the paths of this board, which must not be @p previous
+	 * @return how many different words were found
+	 */
+	int countWords(const QStringList& letters, const Paths& previous, Paths& paths);
+
+	/**
+	 * @return how many different words were found
 	 */
 	int count() const
 	{
@@ -52,12 +162,16 @@ public:
 	}
 
 	/**
+	 * Builds the words and their locations from the paths found by the last solve.
 	 * @return all of the words and their locations on the board
 	 */
-	QHash<QString, QList<QList<QPoint>>> solutions() const
-	{
-		return m_solutions;
-	}
+	QHash<QString, QList<QList<QPoint>>> solutions() const;
+
+	/**
+	 * Builds the words from the paths found by the last solve, without their locations.
+	 * @return each different word on the board, sorted
+	 */
+	QStringList words() const;
 
 	/**
 	 * The maximum score available on the board.
@@ -79,26 +193,122 @@ public:
 	 */
 	void setTrackPositions(bool track_positions);
 
+	/**
+	 * Sets how many threads solve() and countWords() use. Counting words by updating paths always
+	 * uses a single thread. Starting the threads costs more than solving a normal game board, so
+	 * this is only worth it for the largest boards.
+	 * @param count how many threads to use
+	 */
+	void setThreadCount(int count);
+
 private:
 	/**
-	 * Checks if cell is part of or the final cell of a word while solving.
-	 * @param cell location to check
+	 * Sets the contents of the cells. Cells whose letters have not changed are skipped.
+	 * @param letters the board layout
+	 */
+	void setLetters(const QStringList& letters);
+
+	/**
+	 * Finds the face matching some text, resolving it if it has not been seen before.
+	 * @param letter the text of the face
+	 * @return index of the face
+	 */
+	int face(const QString& letter);
+
+	/**
+	 * Walks the letters of a face with more than one letter, using the cached walk if there is one.
+	 * @param face the face to walk
+	 * @param node the node to start from
+	 * @param[in,out] word the number of the word, which is increased by the walk
+	 * @return node of the last letter of the face or @c nullptr if the word list does not have it
+	 */
+	const Trie::Node* walk(Face& face, const Trie::Node* node, quint32& word) const;
+
+	/**
+	 * Starts a new generation of found words.
+	 */
+	void startSearch();
+
+	/**
+	 * Finds every word on the board using the worker solvers, and merges their paths, or only
+	 * their words if positions are not tracked.
+	 * @param letters the board layout
+	 * @param track_positions whether to store the words and their locations
+	 */
+	void searchParallel(const QStringList& letters, bool track_positions);
+
+	/**
+	 * Finds every word on the board.
+	 * @tparam TrackPositions whether to store the words and their locations
+	 * @param first the first cell to start words from
+	 * @param step how many cells to skip between cells to start words from
+	 */
+	template<bool TrackPositions>
+	void search(int first = 0, int step = 1);
+
+	/**
+	 * Searches the neighbors of the cells on the stack until the stack is back to @p depth cells.
+	 * @tparam TrackPositions whether to store the words and their locations
+	 * @tparam RecordPaths whether to store the paths found
+	 * @param depth how many cells to leave on the stack
+	 */
+	template<bool TrackPositions, bool RecordPaths>
+	void searchStack(int depth);
+
+	/**
+	 * Checks if cell continues the word on top of the stack, and pushes it onto the stack if so.
+	 * @tparam TrackPositions whether to store the words and their locations
+	 * @tparam RecordPaths whether to store the paths found
+	 * @param cell index of the cell to check
+	 */
+	template<bool TrackPositions, bool RecordPaths>
+	void checkCell(int cell);
+
+	/**
+	 * Removes the paths found by the last solve.
 	 */
-	void checkCell(Cell& cell);
+	void clearSolutions();
+
+	/**
+	 * Marks a word as found.
+	 * @param word the number of the word in the word list
+	 * @return @c true if the word had not been found yet
+	 */
+	bool addWord(quint32 word);
+
+	/**
+	 * Stores the cells of the word on the stack.
+	 * @param word the number of the word in the word list
+	 */
+	void addSolution(quint32 word);
 
 private:
 	const Trie* m_words; /**< fast access word list */
-	const Trie::Node* m_node; /**< current letter being checked in word list */
-	int m_size; /**< how many cells wide is the board */
+	int m_width; /**< how many cells wide is the board */
+	int m_height; /**< how many cells tall is the board */
 	int m_minimum; /**< the shortest allowed word */
 	bool m_track_positions; /**< remember locations of each word when solving */
-	QList<QList<Cell>> m_cells; /**< layout of board */
+	QList<quint64> m_neighbors; /**< mask of the cells next to each cell */
+	QList<Cell> m_cells; /**< layout of board in row-major order */
+	QList<Face> m_faces; /**< faces that have been resolved */
+	QHash<QString, int> m_face_indexes; /**< location of each face in the list of faces */
+
+	QList<Frame> m_stack; /**< cells of the word being assembled */
+	int m_depth; /**< how many cells are in the word being assembled */
+	QList<Path>* m_paths; /**< where to store paths found when updating paths */
 
-	QString m_word; /**< word currently being assembled */
-	QList<QPoint> m_positions; /**< locations of letters in word being assembled */
+	QList<quint32> m_solution_words; /**< number of the word spelled by each path found */
+	QList<qsizetype> m_solution_offsets; /**< where each path starts in the list of cells, followed by where the last one ends */
+	QList<quint8> m_solution_cells; /**< cells of every path found, one path after another */
+	QList<int> m_solution_lengths; /**< how many letters are in each different word found */
+	QList<quint32> m_stamps; /**< generation of the last solve to find each word in the word list */
+	quint32 m_generation; /**< generation of the current solve */
+	int m_count; /**< how many different words have been found */
 
-	QHash<QString, QList<QList<QPoint>>> m_solutions; /**< words found and their positions on the board */
-	int m_count; /**< how many words have been found */
+	int m_thread_count; /**< how many threads solve the board */
+	bool m_record_words; /**< store each different word when counting, so that the words of workers can be merged */
+	std::unique_ptr<QThreadPool> m_pool; /**< threads used to solve the board */
+	std::vector<std::unique_ptr<Solver>> m_workers; /**< solvers used by each thread */
 };
 
 #endif // TANGLET_SOLVER_H
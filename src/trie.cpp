@@ -6,196 +6,1121 @@
 
 #include "trie.h"
 
-#include <QDataStream>
-#include <QTextStream>
+#include "gzip.h"
 
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <map>
 #include <queue>
 #include <utility>
+#include <vector>
+
+#include <zlib.h>
 
 //-----------------------------------------------------------------------------
 
 namespace
 {
 
+constexpr quint32 TANGLET_CACHE_MAGICNUMBER = 0x54524945;
+constexpr quint32 TANGLET_CACHE_VERSION = 9;
+constexpr qsizetype TANGLET_QUEUE_SIZE = 0x1000000;
+
+/**
+ * @brief The Header struct describes the contents of a trie image.
+ */
+struct Header
+{
+	quint32_le magic; /**< identifies the image as a trie */
+	quint32_le version; /**< format of the image */
+	quint32_le node_count; /**< how many nodes are in the node table */
+	quint32_le alphabet_size; /**< how many distinct letters are in the trie */
+	quint32_le word_count; /**< how many words are in the trie */
+	quint32_le spelling_count; /**< how many spellings are in the spellings blob */
+	quint32_le spelling_text_size; /**< how many UTF-16 code units are in the spellings blob */
+	quint32_le checksum; /**< CRC-32 of the image with this field set to zero */
+	quint16 byte_order_mark; /**< U+FEFF in host byte order, which is the order of the spellings blob */
+	quint16 reserved; /**< unused */
+	quint32_le padding; /**< keeps the node table aligned */
+};
+
+/**
+ * @brief The Layout struct contains the byte offsets of each section of a trie image.
+ */
+struct Layout
+{
+	/**
+	 * Finds the location of each section of a trie image.
+	 * @param header the sizes of the sections
+	 */
+	explicit Layout(const Header& header)
+		: nodes(sizeof(Header))
+		, child_masks(nodes + (qint64(header.node_count) * sizeof(Trie::Node)))
+		, word_offsets(child_masks + ((header.alphabet_size <= 64) ? (qint64(header.node_count) * sizeof(quint64)) : 0))
+		, words(word_offsets + (qint64(header.node_count) * sizeof(quint32)))
+		, spelling_offsets(words + ((qint64(header.word_count) + 1) * sizeof(quint32)))
+		, spelling_text(spelling_offsets + ((qint64(header.spelling_count) + 1) * sizeof(quint32)))
+		, alphabet(spelling_text + (qint64(header.spelling_text_size) * sizeof(quint16)))
+		, size(alphabet + (qint64(header.alphabet_size) * sizeof(quint16)))
+	{
+	}
+
+	const qint64 nodes; /**< start of the node table */
+	const qint64 child_masks; /**< start of the masks of which letters each node has as children */
+	const qint64 word_offsets; /**< start of the word numbering of each node */
+	const qint64 words; /**< start of the first spelling of each word */
+	const qint64 spelling_offsets; /**< start of the offsets into the spellings blob */
+	const qint64 spelling_text; /**< start of the spellings blob */
+	const qint64 alphabet; /**< start of the sorted list of letters */
+	const qint64 size; /**< total size of the image */
+};
+
+static_assert(sizeof(Header) == 40, "Trie header must have fixed size");
+static_assert(sizeof(Trie::Node) == 8, "Trie node must have fixed size");
+
+/**
+ * Computes the checksum of a trie image.
+ * @param image the start of the image
+ * @param size how many bytes are in the image
+ * @return CRC-32 of the image with the checksum in the header set to zero
+ */
+quint32 checksum(const uchar* image, qint64 size)
+{
+	Header header;
+	std::memcpy(&header, image, sizeof(Header));
+	header.checksum = 0;
+	uLong crc = crc32(0L, Z_NULL, 0);
+	crc = crc32(crc, reinterpret_cast<const Bytef*>(&header), sizeof(Header));
+
+	// Checksum in pieces because zlib only takes 32-bit lengths
+	for (qint64 offset = sizeof(Header); offset < size; offset += 0x40000000) {
+		crc = crc32(crc, image + offset, uInt(std::min<qint64>(0x40000000, size - offset)));
+	}
+	return crc;
+}
+
+/**
+ * @brief The Index struct tracks which lists of children have been seen while minimizing a trie.
+ */
+struct Index
+{
+	bool minimize; /**< whether identical lists of children are shared */
+	QHash<quint64, quint32> nodes; /**< identifiers of nodes by letter, word flag, and children */
+	QHash<QList<quint32>, quint32> blocks; /**< identifiers of lists of children */
+	quint32 next_block; /**< identifier of the next unique list of children */
+	std::vector<quint32> ids; /**< identifiers of shared items plus one, or 0 if not counted yet */
+};
+
+/**
+ * The words of a word list grouped by first letter. Each word is packed as its length and letters
+ * followed by how many spellings it has and the length and letters of each spelling.
+ */
+typedef QMap<char16_t, std::vector<char16_t>> Shards;
+
+/**
+ * Checks if a byte of a word list separates the words of a line.
+ * @param c the byte to check
+ * @return whether @p c is whitespace
+ */
+bool isSpace(char c)
+{
+	return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '\v') || (c == '\f');
+}
+
+/**
+ * Decodes UTF-8 text without creating a string.
+ * @param begin the start of the text
+ * @param end the end of the text
+ * @param [out] text where to append the UTF-16 code units
+ */
+void appendUtf8(const char* begin, const char* end, std::vector<char16_t>& text)
+{
+	const uchar* i = reinterpret_cast<const uchar*>(begin);
+	const uchar* last = reinterpret_cast<const uchar*>(end);
+	while (i < last) {
+		const uchar c = *i++;
+		if (c < 0x80) {
+			text.push_back(c);
+			continue;
+		}
+
+		int extra = 0;
+		char32_t unicode = 0;
+		char32_t minimum = 0;
+		if ((c & 0xE0) == 0xC0) {
+			extra = 1;
+			unicode = c & 0x1F;
+			minimum = 0x80;
+		} else if ((c & 0xF0) == 0xE0) {
+			extra = 2;
+			unicode = c & 0x0F;
+			minimum = 0x800;
+		} else if ((c & 0xF8) == 0xF0) {
+			extra = 3;
+			unicode = c & 0x07;
+			minimum = 0x10000;
+		} else {
+			text.push_back(QChar::ReplacementCharacter);
+			continue;
+		}
+
+		int found = 0;
+		for (; (found < extra) && (i < last) && ((*i & 0xC0) == 0x80); ++found, ++i) {
+			unicode = (unicode << 6) | (*i & 0x3F);
+		}
+		if ((found < extra) || (unicode < minimum) || (unicode > 0x10FFFF) || QChar::isSurrogate(unicode)) {
+			text.push_back(QChar::ReplacementCharacter);
+		} else if (QChar::requiresSurrogates(unicode)) {
+			text.push_back(QChar::highSurrogate(unicode));
+			text.push_back(QChar::lowSurrogate(unicode));
+		} else {
+			text.push_back(unicode);
+		}
+	}
+}
+
+/**
+ * Converts text to uppercase in place. Text outside of ASCII is converted by QString so that
+ * letters which change length, such as ß becoming SS, match QString::toUpper().
+ * @param [in,out] text the UTF-16 code units to convert
+ * @param [in,out] buffer reusable string for converting text outside of ASCII
+ */
+void toUpper(std::vector<char16_t>& text, QString& buffer)
+{
+	if (std::all_of(text.cbegin(), text.cend(), [](char16_t c) { return c < 0x80; })) {
+		for (char16_t& c : text) {
+			if ((c >= 'a') && (c <= 'z')) {
+				c -= 'a' - 'A';
+			}
+		}
+		return;
+	}
+
+	buffer.resize(text.size());
+	std::copy(text.cbegin(), text.cend(), reinterpret_cast<char16_t*>(buffer.data()));
+	buffer = std::move(buffer).toUpper();
+	text.assign(buffer.utf16(), buffer.utf16() + buffer.length());
+}
+
+/**
+ * Reads the packed words of a block of a word list.
+ * @param shard the packed words
+ * @param function called with the letters, length, packed spellings, and size of packed spellings
+ * of each word
+ */
+template<typename Function>
+void readShard(const std::vector<char16_t>& shard, Function function)
+{
+	const char16_t* packed = shard.data();
+	const char16_t* end = packed + shard.size();
+	while (packed != end) {
+		const size_t length = *packed++;
+		const char16_t* word = packed;
+		packed += length;
+
+		const char16_t* spellings = packed;
+		for (int count = *packed++; count > 0; --count) {
+			packed += *packed + 1;
+		}
+
+		function(word, length, spellings, packed - spellings);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
 /**
  * @brief The TrieGenerator class generates the optimized word list for the trie class.
+ *
+ * Generators are stored in a single arena and link to each other by index instead of by pointer,
+ * so building a large word list does not allocate each letter separately and freeing it is a
+ * single deallocation.
  */
 class TrieGenerator
 {
 public:
 	/**
-	 * Constructs a generator instance.
-	 * @param key the letter contained by the generator instance
+	 * Constructs an empty generator instance.
+	 * @param sorted whether words are expected to be added in sorted order
 	 */
-	explicit TrieGenerator(const QChar& key = QChar())
-		: m_key(key)
-		, m_word(false)
-		, m_children(nullptr)
-		, m_next(nullptr)
-		, m_count(0)
-	{
-	}
+	explicit TrieGenerator(bool sorted = false);
 
 	/**
 	 * Constructs a generator instance.
 	 * @param word a list of letters to build child instances from
 	 */
-	explicit TrieGenerator(const QString& word)
-		: m_word(false)
-		, m_children(nullptr)
-		, m_next(nullptr)
-		, m_count(0)
-	{
-		addWord(word, QStringList(word));
-	}
+	explicit TrieGenerator(const QString& word);
 
 	/**
-	 * Constructs a generator instance.
-	 * @param data contents of a word list file including alternate spellings
+	 * Constructs a generator instance by merging the generators of each first letter under a
+	 * single root. Each generator is freed as soon as it has been merged.
+	 * @param letters the generators of each first letter, in alphabetical order
+	 * @param minimize whether to share identical lists of children between nodes
 	 */
-	explicit TrieGenerator(const QByteArray& data);
+	explicit TrieGenerator(std::vector<TrieGenerator>&& letters, bool minimize);
 
 	/**
-	 * Destroys the generator.
+	 * Adds the packed words of a block of a word list. Words are added without searching for
+	 * their letters while they are sorted, and identical lists of children are shared as soon as
+	 * they are finished. The first word that is out of order changes the generator to searching
+	 * for the letters of every word instead.
+	 * @param shard the packed words to add, in file order
+	 * @param minimize whether to share identical lists of children between items
 	 */
-	~TrieGenerator();
+	void addWords(const std::vector<char16_t>& shard, bool minimize);
+
+	/**
+	 * Finishes the items of the last sorted word.
+	 * @param minimize whether to share identical lists of children between items
+	 */
+	void finish(bool minimize);
 
 	/**
 	 * Compiles a compressed list of the trie for faster access.
 	 * @param [out] nodes the compressed list of nodes
-	 * @param [out] spellings the list of spellings
+	 * @param [out] word_offsets how many words come before each node among its siblings
+	 * @param [out] words the first spelling of each word in depth-first order
+	 * @param [out] spelling_offsets where each spelling starts in @p spelling_text
+	 * @param [out] spelling_text the text of every spelling
+	 * @param minimize whether to share identical lists of children between nodes
 	 */
-	void run(QList<Trie::Node>& nodes, QStringList& spellings) const;
+	void run(QList<Trie::Node>& nodes, QList<quint32>& word_offsets, QList<quint32>& words, QList<quint32>& spelling_offsets, QString& spelling_text, bool minimize);
 
 private:
 	/**
-	 * Fetch a child generator matching a specific letter. Creates one if does not exist yet.
+	 * @brief The Item struct contains a letter of the generator.
+	 */
+	struct Item
+	{
+		char16_t key; /**< letter represented by the item */
+		bool word; /**< is this item a word */
+		quint32 children; /**< index of first child item, or 0 if there are none */
+		quint32 next; /**< index of next sibling item, or 0 if there are none */
+		quint32 count; /**< how many children the item has */
+		quint32 spellings; /**< offset of packed spellings if item is a word */
+		quint32 total; /**< how many words can be reached from the item */
+		quint32 block; /**< identifier shared by every identical list of children */
+	};
+
+	/**
+	 * Fetch a child item matching a specific letter. Creates one if does not exist yet.
+	 * Children are kept sorted by letter.
+	 * @param parent the index of the parent item
 	 * @param letter the letter to add
-	 * @return the child generator
+	 * @return the index of the child item
 	 */
-	TrieGenerator* addChild(const QChar& letter);
+	quint32 addChild(quint32 parent, char16_t letter);
 
 	/**
 	 * Adds a word by walking through the letters and fetching the next child of each letter.
-	 * @param word the word to add
-	 * @param spellings alternate spellings of the word to store
+	 * @param word the letters of the word to add
+	 * @param length how many letters are in the word
+	 * @param spellings packed alternate spellings of the word to store
+	 * @param size how many code units are in @p spellings
+	 */
+	void addWord(const char16_t* word, size_t length, const char16_t* spellings, size_t size);
+
+	/**
+	 * Adds a word that sorts after every word added so far. Only the letters that differ from the
+	 * previous word need to be added, and they are always the last child of their parent.
+	 * @param word the letters of the word to add
+	 * @param length how many letters are in the word
+	 * @param spellings packed alternate spellings of the word to store
+	 * @param size how many code units are in @p spellings
+	 * @param minimize whether to share identical lists of children between items
+	 */
+	void addSortedWord(const char16_t* word, size_t length, const char16_t* spellings, size_t size, bool minimize);
+
+	/**
+	 * Finishes the items of the previous sorted word below a depth. When minimizing, an item whose
+	 * children match a list that is already finished shares that list instead, and its own
+	 * children are discarded; they are always at the end of the arena.
+	 * @param depth how many letters of the previous word are still in use
+	 * @param minimize whether to share identical lists of children between items
+	 * @return the index of the last finished item, or 0 if none were finished
+	 */
+	quint32 finishPath(size_t depth, bool minimize);
+
+	/**
+	 * Checks if two lists of children have the same letters, word flags, and children.
+	 * @param first the index of the first item of one list
+	 * @param second the index of the first item of the other list
+	 * @return whether the lists are identical
+	 */
+	bool sameChildren(quint32 first, quint32 second) const;
+
+	/**
+	 * Stops adding words in sorted order. Shared lists of children are copied for each word that
+	 * reaches them, so that more words can be added to them.
+	 * @param minimize whether identical lists of children were shared
 	 */
-	void addWord(const QString& word, const QStringList& spellings);
+	void unshare(bool minimize);
 
-	// Uncopyable
-	TrieGenerator(const TrieGenerator&) = delete;
-	TrieGenerator& operator=(const TrieGenerator&) = delete;
+	/**
+	 * Adds the words below an item to another generator, in sorted order.
+	 * @param item the index of the item to copy the children of
+	 * @param [in,out] word the letters leading to @p item
+	 * @param [in,out] spellings the packed spellings of the next word
+	 * @param [out] generator where to add the words
+	 */
+	void copyWords(quint32 item, std::vector<char16_t>& word, const char16_t*& spellings, TrieGenerator& generator) const;
+
+	/**
+	 * Appends the spellings of a word to the lists of spellings.
+	 * @param packed the packed spellings of the word
+	 * @param [out] words the first spelling of each word in depth-first order
+	 * @param [out] spelling_offsets where each spelling starts in @p spelling_text
+	 * @param [out] spelling_text the text of every spelling
+	 * @return the packed spellings of the next word
+	 */
+	static const char16_t* unpackSpellings(const char16_t* packed, QList<quint32>& words, QList<quint32>& spelling_offsets, QString& spelling_text);
+
+	/**
+	 * Counts the words of each item, collects their spellings, and finds which items have
+	 * identical children.
+	 * @param item the index of the item to count
+	 * @param [in,out] index the children that have been seen so far
+	 * @param [out] words the first spelling of each word in depth-first order
+	 * @param [out] spelling_offsets where each spelling starts in @p spelling_text
+	 * @param [out] spelling_text the text of every spelling
+	 * @return identifier shared by every item equivalent to this one
+	 */
+	quint32 index(quint32 item, Index& index, QList<quint32>& words, QList<quint32>& spelling_offsets, QString& spelling_text);
 
 private:
-	QChar m_key; /**< letter represented by the generator */
-	bool m_word; /**< is this node a word */
-	TrieGenerator* m_children; /**< first child generator */
-	TrieGenerator* m_next; /**< first sibling generator */
-	int m_count; /**< how many children the generator has */
-	QStringList m_spellings; /**< alternate spellings of word */
+	std::vector<Item> m_items; /**< arena of items, with the root first */
+	std::vector<char16_t> m_spellings; /**< packed alternate spellings of words */
+	bool m_sorted; /**< whether words were added in sorted order, which makes @a m_spellings in word order */
+	std::vector<quint32> m_path; /**< items of the previous sorted word, starting with the root */
+	std::vector<char16_t> m_previous; /**< letters of the previous sorted word */
+	QMultiHash<quint64, quint32> m_finished; /**< first items of finished lists of children by hash of their letters, word flags, and children */
 };
 
 //-----------------------------------------------------------------------------
 
-TrieGenerator::TrieGenerator(const QByteArray& data)
-	: m_word(false)
-	, m_children(nullptr)
-	, m_next(nullptr)
-	, m_count(0)
+TrieGenerator::TrieGenerator(bool sorted)
+	: m_items(1, Item())
+	, m_sorted(sorted)
+	, m_path(1, 0)
 {
-	QTextStream stream(data);
-	while (!stream.atEnd()) {
-		QStringList spellings = stream.readLine().simplified().split(QChar(' '), Qt::SkipEmptyParts);
-		if (spellings.isEmpty()) {
-			continue;
+}
+
+//-----------------------------------------------------------------------------
+
+TrieGenerator::TrieGenerator(const QString& word)
+	: TrieGenerator()
+{
+	std::vector<char16_t> spellings;
+	spellings.push_back(1);
+	spellings.push_back(word.length());
+	spellings.insert(spellings.end(), word.utf16(), word.utf16() + word.length());
+	addWord(reinterpret_cast<const char16_t*>(word.utf16()), word.length(), spellings.data(), spellings.size());
+}
+
+//-----------------------------------------------------------------------------
+
+TrieGenerator::TrieGenerator(std::vector<TrieGenerator>&& letters, bool minimize)
+	: TrieGenerator()
+{
+	// Spellings are only in word order if every letter was sorted
+	m_sorted = std::all_of(letters.cbegin(), letters.cend(), [](const TrieGenerator& letter) { return letter.m_sorted; });
+	if (!m_sorted) {
+		QThreadPool pool;
+		for (TrieGenerator& letter : letters) {
+			TrieGenerator* generator = &letter;
+			pool.start([generator, minimize] {
+				generator->unshare(minimize);
+			});
 		}
+		pool.waitForDone();
+	}
+
+	// Merge letters under the root, which is the only item they have in common
+	size_t size = 1;
+	size_t spellings_size = 0;
+	for (const TrieGenerator& generator : letters) {
+		size += generator.m_items.size() - 1;
+		spellings_size += generator.m_spellings.size();
+	}
+	m_items.reserve(size);
+	m_spellings.reserve(spellings_size);
 
-		QString word = spellings.first().toUpper();
-		if (spellings.count() == 1) {
-			spellings[0] = word.toLower();
+	quint32 previous = 0;
+	for (TrieGenerator& generator : letters) {
+		const quint32 offset = m_items.size() - 1;
+		const quint32 spellings = m_spellings.size();
+		for (auto i = generator.m_items.cbegin() + 1; i != generator.m_items.cend(); ++i) {
+			Item item = *i;
+			item.children += item.children ? offset : 0;
+			item.next += item.next ? offset : 0;
+			item.spellings += item.word ? spellings : 0;
+			m_items.push_back(item);
+		}
+		m_spellings.insert(m_spellings.end(), generator.m_spellings.cbegin(), generator.m_spellings.cend());
+
+		const quint32 letter = generator.m_items.front().children + offset;
+		if (previous) {
+			m_items[previous].next = letter;
 		} else {
-			spellings.removeFirst();
+			m_items.front().children = letter;
+		}
+		m_items.front().count++;
+		previous = letter;
+
+		generator = TrieGenerator();
+	}
+	letters.clear();
+}
+
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief The WordListReader class builds a word list on a thread pool while it is being read.
+ *
+ * Lines are parsed in place and packed into shards by first letter, so no strings are created
+ * for words that are not kept. Each shard is added to the generator of its letter as soon as
+ * the blocks before it have been handed out, and reading waits while too many parsed words are
+ * waiting to be added, so the word list is never held in memory at once.
+ */
+class WordListReader
+{
+public:
+	/**
+	 * Constructs a reader instance.
+	 * @param minimize whether to share identical lists of children between nodes
+	 */
+	explicit WordListReader(bool minimize);
+
+	/**
+	 * Queues the complete lines of a block of the word list to be parsed.
+	 * @param data the start of the block
+	 * @param size how many bytes are in the block
+	 */
+	void append(const char* data, qsizetype size);
+
+	/**
+	 * Parses any remaining text and waits for every word to be added.
+	 * @return the generators of each first letter, in alphabetical order, which are moved out
+	 * of the reader
+	 */
+	std::vector<TrieGenerator> finish();
+
+private:
+	/**
+	 * @brief The Letter struct tracks the words of a first letter.
+	 */
+	struct Letter
+	{
+		Letter()
+			: generator(true)
+			, running(false)
+		{
+		}
+
+		TrieGenerator generator; /**< builds the words of the letter */
+		std::deque<std::vector<char16_t>> shards; /**< packed words waiting to be added, in file order */
+		bool running; /**< whether a thread is adding words to the generator */
+	};
+
+	/**
+	 * Hands the shards of every parsed block that follows the blocks handed out so far to their
+	 * letters, and starts adding them.
+	 * @param block the position of the parsed block in the word list
+	 * @param size how many bytes of lines were parsed
+	 * @param shards the words of the block grouped by first letter
+	 */
+	void parsed(qsizetype block, qsizetype size, Shards&& shards);
+
+	/**
+	 * Adds the shards of a letter until none are waiting.
+	 * @param letter the letter to add words to
+	 */
+	void build(Letter& letter);
+
+	/**
+	 * Parses the lines of a block.
+	 * @param lines the complete lines to parse
+	 * @param [out] shards the words of the block grouped by first letter
+	 */
+	static void parse(const QByteArray& lines, Shards& shards);
+
+	/**
+	 * Stores the words of a line.
+	 * @param begin the start of the line
+	 * @param end the end of the line
+	 * @param [out] fields buffer for the decoded text of each field
+	 * @param [out] word buffer for converting the case of the word
+	 * @param [out] buffer reusable string for converting text outside of ASCII
+	 * @param [out] shards the words grouped by first letter
+	 */
+	static void parseLine(const char* begin, const char* end, std::vector<char16_t>& fields, std::vector<char16_t>& word, QString& buffer, Shards& shards);
+
+private:
+	QThreadPool m_pool; /**< threads used to parse blocks and add words */
+	QMutex m_mutex; /**< guards the parsed blocks, the waiting shards, and how many bytes are waiting */
+	QWaitCondition m_added; /**< signaled when words have been parsed or added */
+	std::map<qsizetype, Shards> m_parsed; /**< parsed blocks waiting for the blocks before them */
+	std::map<char16_t, Letter> m_letters; /**< the words of each first letter */
+	qsizetype m_queued; /**< how many bytes of lines and parsed words are waiting to be added */
+	qsizetype m_blocks; /**< how many blocks have been queued */
+	qsizetype m_next_block; /**< the position of the next block to hand out */
+	QByteArray m_partial; /**< start of a line that continues in the next block */
+	bool m_minimize; /**< whether to share identical lists of children between nodes */
+	bool m_started; /**< whether any text has been read */
+};
+
+//-----------------------------------------------------------------------------
+
+WordListReader::WordListReader(bool minimize)
+	: m_queued(0)
+	, m_blocks(0)
+	, m_next_block(0)
+	, m_minimize(minimize)
+	, m_started(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+void WordListReader::append(const char* data, qsizetype size)
+{
+	// Skip byte order mark
+	if (!m_started && (size > 0)) {
+		m_started = true;
+		if ((size >= 3) && (std::memcmp(data, "\xEF\xBB\xBF", 3) == 0)) {
+			data += 3;
+			size -= 3;
 		}
+	}
 
-		if (word.length() >= 3 && word.length() <= 25) {
-			addWord(word, spellings);
+	// Only parse complete lines
+	const char* end = data + size;
+	while ((end != data) && (end[-1] != '\n')) {
+		--end;
+	}
+	if (end == data) {
+		m_partial.append(data, size);
+		return;
+	}
+
+	QByteArray lines = m_partial;
+	lines.append(data, end - data);
+	m_partial = QByteArray(end, (data + size) - end);
+
+	// Wait for words to be added before reading more of the word list
+	{
+		QMutexLocker locker(&m_mutex);
+		while (m_queued > TANGLET_QUEUE_SIZE) {
+			m_added.wait(&m_mutex);
 		}
+		m_queued += lines.size();
 	}
+
+	const qsizetype block = m_blocks++;
+	m_pool.start([this, lines, block] {
+		Shards shards;
+		parse(lines, shards);
+		parsed(block, lines.size(), std::move(shards));
+	});
 }
 
 //-----------------------------------------------------------------------------
 
-TrieGenerator::~TrieGenerator()
+std::vector<TrieGenerator> WordListReader::finish()
 {
-	delete m_children;
-	delete m_next;
+	if (!m_partial.isEmpty()) {
+		m_partial.append('\n');
+		const QByteArray lines = m_partial;
+		m_partial.clear();
+		append(lines.constData(), lines.size());
+	}
+	m_pool.waitForDone();
+
+	// Finish each letter separately
+	for (auto& letter : m_letters) {
+		TrieGenerator* generator = &letter.second.generator;
+		const bool minimize = m_minimize;
+		m_pool.start([generator, minimize] {
+			generator->finish(minimize);
+		});
+	}
+	m_pool.waitForDone();
+
+	std::vector<TrieGenerator> generators;
+	generators.reserve(m_letters.size());
+	for (auto& letter : m_letters) {
+		generators.push_back(std::move(letter.second.generator));
+	}
+	m_letters.clear();
+	return generators;
 }
 
 //-----------------------------------------------------------------------------
 
-TrieGenerator* TrieGenerator::addChild(const QChar& letter)
+void WordListReader::parsed(qsizetype block, qsizetype size, Shards&& shards)
 {
-	if (!m_children) {
-		m_children = new TrieGenerator(letter);
-		m_count = 1;
-		return m_children;
+	QMutexLocker locker(&m_mutex);
+
+	// Count the parsed words instead of the lines
+	m_queued -= size;
+	for (const std::vector<char16_t>& shard : std::as_const(shards)) {
+		m_queued += shard.size() * sizeof(char16_t);
 	}
+	m_parsed.emplace(block, std::move(shards));
+
+	// Hand out blocks in file order so that duplicate words keep their order
+	for (auto i = m_parsed.begin(); (i != m_parsed.end()) && (i->first == m_next_block); i = m_parsed.erase(i)) {
+		++m_next_block;
+		for (auto j = i->second.begin(), end = i->second.end(); j != end; ++j) {
+			Letter& letter = m_letters[j.key()];
+			letter.shards.push_back(std::move(j.value()));
+			if (!letter.running) {
+				letter.running = true;
+				Letter* builder = &letter;
+				m_pool.start([this, builder] {
+					build(*builder);
+				});
+			}
+		}
+	}
+
+	m_added.wakeAll();
+}
+
+//-----------------------------------------------------------------------------
+
+void WordListReader::build(Letter& letter)
+{
+	std::vector<char16_t> shard;
+	for (;;) {
+		{
+			QMutexLocker locker(&m_mutex);
+			if (!shard.empty()) {
+				m_queued -= shard.size() * sizeof(char16_t);
+				m_added.wakeAll();
+			}
+			if (letter.shards.empty()) {
+				letter.running = false;
+				return;
+			}
+			shard = std::move(letter.shards.front());
+			letter.shards.pop_front();
+		}
 
-	TrieGenerator* previous = nullptr;
-	TrieGenerator* current = m_children;
-	while (current && current->m_key != letter) {
+		letter.generator.addWords(shard, m_minimize);
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+void WordListReader::parse(const QByteArray& lines, Shards& shards)
+{
+	std::vector<char16_t> fields;
+	std::vector<char16_t> word;
+	QString buffer;
+
+	const char* start = lines.constData();
+	const char* end = start + lines.size();
+	while (start != end) {
+		const char* next = std::find(start, end, '\n');
+		parseLine(start, next, fields, word, buffer, shards);
+		start = (next == end) ? end : (next + 1);
+	}
+}
+
+//-----------------------------------------------------------------------------
+void WordListReader::parseLine(const char* begin, const char* end, std::vector<char16_t>& fields, std::vector<char16_t>& word, QString& buffer, Shards& shards)
+{
+	// Decode each field of the line, prefixed by its length
+	fields.clear();
+	int count = 0;
+	while (begin != end) {
+		if (isSpace(*begin)) {
+			++begin;
+			continue;
+		}
+
+		const char* field = begin;
+		while ((begin != end) && !isSpace(*begin)) {
+			++begin;
+		}
+
+		const size_t start = fields.size();
+		fields.push_back(0);
+		appendUtf8(field, begin, fields);
+		const size_t length = fields.size() - start - 1;
+		if (length > 0xFFFF) {
+			return;
+		}
+		fields[start] = length;
+		++count;
+	}
+	if (!count || (count > 0xFFFF)) {
+		return;
+	}
+
+	// Only keep words that fit on a board
+	word.assign(fields.cbegin() + 1, fields.cbegin() + 1 + fields.front());
+	toUpper(word, buffer);
+	if (word.size() < 3 || word.size() > 25) {
+		return;
+	}
+
+	std::vector<char16_t>& shard = shards[word.front()];
+	shard.push_back(word.size());
+	shard.insert(shard.end(), word.cbegin(), word.cend());
+
+	// Words without spellings are spelled as the lowercase of the word, which is not stored
+	if (count == 1) {
+		shard.push_back(0);
+	} else {
+		shard.push_back(count - 1);
+		shard.insert(shard.end(), fields.cbegin() + 1 + fields.front(), fields.cend());
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+quint32 TrieGenerator::addChild(quint32 parent, char16_t letter)
+{
+	// Keep children sorted so that they match the order of the alphabet
+	quint32 previous = 0;
+	quint32 current = m_items[parent].children;
+	while (current && m_items[current].key < letter) {
 		previous = current;
-		current = current->m_next;
+		current = m_items[current].next;
 	}
 
-	if (!current) {
-		previous->m_next = current = new TrieGenerator(letter);
-		m_count++;
+	if (!current || (m_items[current].key != letter)) {
+		Item child = Item();
+		child.key = letter;
+		child.next = current;
+		current = m_items.size();
+		m_items.push_back(child);
+
+		if (previous) {
+			m_items[previous].next = current;
+		} else {
+			m_items[parent].children = current;
+		}
+		m_items[parent].count++;
 	}
 	return current;
 }
 
 //-----------------------------------------------------------------------------
 
-void TrieGenerator::addWord(const QString& word, const QStringList& spellings)
+void TrieGenerator::addWord(const char16_t* word, size_t length, const char16_t* spellings, size_t size)
+{
+	quint32 item = 0;
+	for (size_t i = 0; i < length; ++i) {
+		item = addChild(item, word[i]);
+	}
+
+	Item& node = m_items[item];
+	node.word = true;
+	node.spellings = m_spellings.size();
+	m_spellings.insert(m_spellings.end(), spellings, spellings + size);
+}
+
+//-----------------------------------------------------------------------------
+
+void TrieGenerator::addSortedWord(const char16_t* word, size_t length, const char16_t* spellings, size_t size, bool minimize)
+{
+	// Finish the letters of the previous word that are not shared
+	const size_t shared = std::mismatch(word, word + std::min(length, m_previous.size()), m_previous.cbegin()).first - word;
+	quint32 previous = finishPath(shared, minimize);
+
+	// Append the remaining letters as the last children of the path
+	quint32 parent = m_path.back();
+	for (size_t i = shared; i < length; ++i) {
+		Item child = Item();
+		child.key = word[i];
+		const quint32 current = m_items.size();
+		m_items.push_back(child);
+
+		if (previous) {
+			m_items[previous].next = current;
+		} else {
+			m_items[parent].children = current;
+		}
+		m_items[parent].count++;
+		m_path.push_back(current);
+
+		parent = current;
+		previous = 0;
+	}
+
+	Item& node = m_items[parent];
+	node.word = true;
+	node.spellings = m_spellings.size();
+	m_spellings.insert(m_spellings.end(), spellings, spellings + size);
+	m_previous.assign(word, word + length);
+}
+
+//-----------------------------------------------------------------------------
+
+quint32 TrieGenerator::finishPath(size_t depth, bool minimize)
+{
+	quint32 item = 0;
+	while (m_path.size() > depth + 1) {
+		item = m_path.back();
+		m_path.pop_back();
+		if (!minimize || !m_items[item].children) {
+			continue;
+		}
+
+		// Key by a hash of the children, and compare them in the arena instead of copying them
+		quint64 hash = 14695981039346656037ULL;
+		for (quint32 child = m_items[item].children; child; child = m_items[child].next) {
+			const Item& node = m_items[child];
+			hash = (hash ^ ((quint64(node.children) << 17) | (quint64(node.word) << 16) | node.key)) * 1099511628211ULL;
+		}
+
+		bool shared = false;
+		for (auto i = m_finished.constFind(hash); (i != m_finished.cend()) && (i.key() == hash); ++i) {
+			if (sameChildren(*i, m_items[item].children)) {
+				m_items.resize(item + 1);
+				m_items[item].children = *i;
+				shared = true;
+				break;
+			}
+		}
+		if (!shared) {
+			m_finished.insert(hash, m_items[item].children);
+		}
+	}
+	return item;
+}
+
+//-----------------------------------------------------------------------------
+
+bool TrieGenerator::sameChildren(quint32 first, quint32 second) const
+{
+	for (; first && second; first = m_items[first].next, second = m_items[second].next) {
+		const Item& a = m_items[first];
+		const Item& b = m_items[second];
+		if ((a.key != b.key) || (a.word != b.word) || (a.children != b.children)) {
+			return false;
+		}
+	}
+	return !first && !second;
+}
+
+//-----------------------------------------------------------------------------
+
+void TrieGenerator::addWords(const std::vector<char16_t>& shard, bool minimize)
+{
+	readShard(shard, [this, minimize](const char16_t* word, size_t length, const char16_t* spellings, size_t size) {
+		// Stop adding in sorted order at the first word that does not sort after the previous one
+		if (m_sorted && !std::lexicographical_compare(m_previous.cbegin(), m_previous.cend(), word, word + length)) {
+			unshare(minimize);
+		}
+
+		if (m_sorted) {
+			addSortedWord(word, length, spellings, size, minimize);
+		} else {
+			addWord(word, length, spellings, size);
+		}
+	});
+}
+
+//-----------------------------------------------------------------------------
+
+void TrieGenerator::finish(bool minimize)
 {
-	TrieGenerator* node = this;
-	for (const QChar& c : word) {
-		node = node->addChild(c);
+	if (m_sorted) {
+		finishPath(0, minimize);
 	}
-	node->m_word = true;
-	node->m_spellings = spellings;
+	m_path = std::vector<quint32>();
+	m_previous = std::vector<char16_t>();
+	m_finished.clear();
 }
 
 //-----------------------------------------------------------------------------
 
-void TrieGenerator::run(QList<Trie::Node>& nodes, QStringList& spellings) const
+void TrieGenerator::unshare(bool minimize)
 {
-	std::queue<std::pair<const TrieGenerator*, int>> next;
+	if (!m_sorted) {
+		return;
+	}
+	m_sorted = false;
+	m_path.assign(1, 0);
+	m_previous.clear();
+	m_finished.clear();
+
+	// Items without shared children can have words added to them as they are
+	if (!minimize) {
+		return;
+	}
+
+	// Copy every word in sorted order, which is the order of their spellings
+	TrieGenerator generator;
+	std::vector<char16_t> word;
+	const char16_t* spellings = m_spellings.data();
+	copyWords(0, word, spellings, generator);
+	*this = std::move(generator);
+}
+
+//-----------------------------------------------------------------------------
+
+void TrieGenerator::copyWords(quint32 item, std::vector<char16_t>& word, const char16_t*& spellings, TrieGenerator& generator) const
+{
+	for (quint32 child = m_items[item].children; child; child = m_items[child].next) {
+		word.push_back(m_items[child].key);
+		if (m_items[child].word) {
+			const char16_t* packed = spellings;
+			for (int count = *spellings++; count > 0; --count) {
+				spellings += *spellings + 1;
+			}
+			generator.addWord(word.data(), word.size(), packed, spellings - packed);
+		}
+		copyWords(child, word, spellings, generator);
+		word.pop_back();
+	}
+}
+
+//-----------------------------------------------------------------------------
+
+const char16_t* TrieGenerator::unpackSpellings(const char16_t* packed, QList<quint32>& words, QList<quint32>& spelling_offsets, QString& spelling_text)
+{
+	words.append(spelling_offsets.count());
+	for (int count = *packed++; count > 0; --count) {
+		const int length = *packed++;
+		spelling_offsets.append(spelling_text.length());
+		spelling_text.append(reinterpret_cast<const QChar*>(packed), length);
+		packed += length;
+	}
+	return packed;
+}
+
+//-----------------------------------------------------------------------------
+
+quint32 TrieGenerator::index(quint32 item, Index& index, QList<quint32>& words, QList<quint32>& spelling_offsets, QString& spelling_text)
+{
+	// Items reached by more than one path only need to be counted once
+	if (!index.ids.empty() && index.ids[item]) {
+		return index.ids[item] - 1;
+	}
+
+	if (m_items[item].word && !m_sorted) {
+		unpackSpellings(&m_spellings[m_items[item].spellings], words, spelling_offsets, spelling_text);
+	}
+
+	quint32 total = m_items[item].word;
+	QList<quint32> children;
+	for (quint32 child = m_items[item].children; child; child = m_items[child].next) {
+		children.append(this->index(child, index, words, spelling_offsets, spelling_text));
+		total += m_items[child].total;
+	}
+
+	Item& node = m_items[item];
+	node.total = total;
+
+	quint32 id = 0;
+	if (!index.minimize) {
+		node.block = index.next_block++;
+		id = node.block;
+	} else {
+		// Find lists of children that have been seen before
+		node.block = 0;
+		if (!children.isEmpty()) {
+			const auto i = index.blocks.constFind(children);
+			if (i != index.blocks.cend()) {
+				node.block = *i;
+			} else {
+				node.block = index.next_block++;
+				index.blocks.insert(children, node.block);
+			}
+		}
+
+		// Find nodes that have been seen before
+		const quint64 key = (quint64(node.block) << 17) | (quint64(node.key) << 1) | node.word;
+		const auto i = index.nodes.constFind(key);
+		if (i != index.nodes.cend()) {
+			id = *i;
+		} else {
+			id = index.nodes.count();
+			index.nodes.insert(key, id);
+		}
+	}
+
+	if (!index.ids.empty()) {
+		index.ids[item] = id + 1;
+	}
+	return id;
+}
+
+//-----------------------------------------------------------------------------
+
+void TrieGenerator::run(QList<Trie::Node>& nodes, QList<quint32>& word_offsets, QList<quint32>& words, QList<quint32>& spelling_offsets, QString& spelling_text, bool minimize)
+{
+	Index generators;
+	generators.minimize = minimize;
+	generators.next_block = 1;
+	if (m_sorted) {
+		generators.ids.resize(m_items.size());
+	}
+	index(0, generators, words, spelling_offsets, spelling_text);
+	generators.ids = std::vector<quint32>();
+
+	// Words were added in sorted order, which is the order they are numbered in
+	if (m_sorted) {
+		const char16_t* packed = m_spellings.data();
+		const char16_t* end = packed + m_spellings.size();
+		while (packed != end) {
+			packed = unpackSpellings(packed, words, spelling_offsets, spelling_text);
+		}
+	}
+	words.append(spelling_offsets.count());
+	spelling_offsets.append(spelling_text.length());
+	generators.nodes.clear();
+	generators.blocks.clear();
+
+	// Lay out nodes breadth-first so that children are contiguous
+	QHash<quint32, quint32> blocks;
+	std::queue<std::pair<quint32, int>> next;
 	nodes.append(Trie::Node());
-	next.emplace(this, 0);
+	word_offsets.append(0);
+	next.emplace(0, 0);
 
 	while (!next.empty()) {
-		auto item = next.front();
+		auto entry = next.front();
 		next.pop();
 
-		const TrieGenerator* trie = item.first;
-		Trie::Node& node = nodes[item.second];
-		node.m_letter = trie->m_key;
-		node.m_word = spellings.count();
-		spellings += trie->m_spellings;
-		node.m_word_count = trie->m_spellings.count();
-		node.m_child_count = trie->m_count;
+		const Item& item = m_items[entry.first];
+		Trie::Node& node = nodes[entry.second];
+		node.m_letter = item.key;
+		node.m_flags = item.word ? Trie::Node::Word : 0;
+		node.m_child_count = item.count;
 
 		if (node.m_child_count) {
+			// Share children that have already been laid out
+			if (minimize) {
+				const auto i = blocks.constFind(item.block);
+				if (i != blocks.cend()) {
+					node.m_children = *i;
+					continue;
+				}
+				blocks.insert(item.block, nodes.count());
+			}
 			node.m_children = nodes.count();
 
-			trie = trie->m_children;
-			int count = node.m_child_count;
-			for (int i = 0; i < count; ++i) {
+			quint32 offset = 0;
+			for (quint32 child = item.children; child; child = m_items[child].next) {
 				nodes.append(Trie::Node());
-				next.emplace(trie, nodes.count() - 1);
-				trie = trie->m_next;
+				word_offsets.append(offset);
+				offset += m_items[child].total;
+				next.emplace(child, nodes.count() - 1);
 			}
 		}
 	}
@@ -206,114 +1131,314 @@ void TrieGenerator::run(QList<Trie::Node>& nodes, QStringList& spellings) const
 //-----------------------------------------------------------------------------
 
 Trie::Trie()
+	: m_image(nullptr)
+	, m_image_size(0)
+	, m_nodes(nullptr)
+	, m_node_count(0)
+	, m_child_masks(nullptr)
+	, m_alphabet(nullptr)
+	, m_alphabet_size(0)
+	, m_word_offsets(nullptr)
+	, m_words(nullptr)
+	, m_word_count(0)
+	, m_spelling_offsets(nullptr)
+	, m_spelling_count(0)
+	, m_spelling_text(nullptr)
+	, m_spelling_text_size(0)
 {
 }
 
 //-----------------------------------------------------------------------------
 
 Trie::Trie(const QString& word)
+	: Trie()
 {
+	QList<Node> nodes;
+	QList<quint32> word_offsets;
+	QList<quint32> words;
+	QList<quint32> spelling_offsets;
+	QString spelling_text;
 	TrieGenerator generator(word);
-	generator.run(m_nodes, m_spellings);
-	checkNodes();
+	generator.run(nodes, word_offsets, words, spelling_offsets, spelling_text, false);
+	setData(nodes, word_offsets, words, spelling_offsets, spelling_text);
 }
 
 //-----------------------------------------------------------------------------
 
-Trie::Trie(const QByteArray& data)
+bool Trie::build(const QString& path, bool minimize)
 {
-	TrieGenerator generator(data);
-	generator.run(m_nodes, m_spellings);
-	checkNodes();
+	clear();
+
+	WordListReader reader(minimize);
+	const bool read = gunzip(path, [&reader](const QByteArray& chunk) {
+		reader.append(chunk.constData(), chunk.size());
+	});
+	std::vector<TrieGenerator> letters = reader.finish();
+	if (!read) {
+		return false;
+	}
+
+	QList<Node> nodes;
+	QList<quint32> word_offsets;
+	QList<quint32> words;
+	QList<quint32> spelling_offsets;
+	QString spelling_text;
+	{
+		TrieGenerator generator(std::move(letters), minimize);
+		generator.run(nodes, word_offsets, words, spelling_offsets, spelling_text, minimize);
+	}
+	setData(nodes, word_offsets, words, spelling_offsets, spelling_text);
+	return !isEmpty();
 }
 
 //-----------------------------------------------------------------------------
 
 void Trie::clear()
 {
-	m_nodes.clear();
-	m_spellings.clear();
+	m_data.reset();
+	m_image = nullptr;
+	m_image_size = 0;
+	m_nodes = nullptr;
+	m_node_count = 0;
+	m_child_masks = nullptr;
+	m_alphabet = nullptr;
+	m_alphabet_size = 0;
+	m_word_offsets = nullptr;
+	m_words = nullptr;
+	m_word_count = 0;
+	m_spelling_offsets = nullptr;
+	m_spelling_count = 0;
+	m_spelling_text = nullptr;
+	m_spelling_text_size = 0;
 }
 
 //-----------------------------------------------------------------------------
 
-void Trie::checkNodes()
+bool Trie::isCache(const QString& path)
 {
-	// Verify that no nodes reference outside list
-	const quint32 count = m_nodes.size();
-	for (const Node& node : std::as_const(m_nodes)) {
-		const quint32 start = node.m_children;
-		const quint32 end = start + node.m_child_count;
-		if ((start >= count) || (end > count)) {
-			clear();
-			break;
-		}
+	QFile file(path);
+	if (!file.open(QFile::ReadOnly)) {
+		return false;
 	}
+
+	Header header;
+	if (file.read(reinterpret_cast<char*>(&header), sizeof(Header)) != qint64(sizeof(Header))) {
+		return false;
+	}
+	return (header.magic == TANGLET_CACHE_MAGICNUMBER) && (header.version == TANGLET_CACHE_VERSION);
 }
 
 //-----------------------------------------------------------------------------
 
-const Trie::Node* Trie::child(const QChar& letter, const Node* node) const
+bool Trie::load(const QString& path)
 {
-	const auto end = m_nodes.cbegin() + node->m_children + node->m_child_count;
-	for (auto i = m_nodes.cbegin() + node->m_children; i < end; ++i) {
-		if (*i == letter) {
-			return &*i;
-		}
+	clear();
+
+	auto file = std::make_shared<QFile>(path);
+	if (!file->open(QFile::ReadOnly)) {
+		return false;
 	}
-	return nullptr;
+
+	const qint64 size = file->size();
+	if (size < qint64(sizeof(Header))) {
+		return false;
+	}
+
+	const uchar* image = file->map(0, size);
+	if (!image) {
+		return false;
+	}
+
+	// Detect damaged caches
+	if (reinterpret_cast<const Header*>(image)->checksum != checksum(image, size)) {
+		return false;
+	}
+
+	return setImage(file, image, size);
 }
 
 //-----------------------------------------------------------------------------
 
-QStringList Trie::spellings(const QString& word, const QStringList& default_value) const
+bool Trie::save(const QString& path) const
 {
-	const Trie::Node* node = &m_nodes[0];
-	const int length = word.length();
-	for (int i = 0; i < length; ++i) {
-		node = child(word.at(i), node);
-		if (!node) {
-			return default_value;
+	if (isEmpty()) {
+		return false;
+	}
+
+	QSaveFile file(path);
+	if (!file.open(QFile::WriteOnly)) {
+		return false;
+	}
+	if (file.write(reinterpret_cast<const char*>(m_image), m_image_size) != m_image_size) {
+		file.cancelWriting();
+		return false;
+	}
+	return file.commit();
+}
+
+//-----------------------------------------------------------------------------
+
+void Trie::setData(const QList<Node>& nodes, const QList<quint32>& word_offsets, const QList<quint32>& words, const QList<quint32>& spelling_offsets, const QString& spelling_text)
+{
+	// Find the letters used by the trie; children are already sorted in alphabet order
+	QList<quint16> alphabet;
+	for (const Node& node : nodes) {
+		alphabet.append(node.m_letter);
+	}
+	std::sort(alphabet.begin(), alphabet.end());
+	alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+	alphabet.removeFirst();
+
+	Header header;
+	header.magic = TANGLET_CACHE_MAGICNUMBER;
+	header.version = TANGLET_CACHE_VERSION;
+	header.node_count = nodes.count();
+	header.alphabet_size = alphabet.count();
+	header.word_count = words.count() - 1;
+	header.spelling_count = spelling_offsets.count() - 1;
+	header.spelling_text_size = spelling_text.length();
+	header.checksum = 0;
+	header.byte_order_mark = 0xFEFF;
+	header.reserved = 0;
+	header.padding = 0;
+	const Layout layout(header);
+
+	// Use 64-bit storage so that every section of the image is aligned
+	auto data = std::make_shared<std::vector<quint64>>((layout.size + 7) / 8);
+	uchar* image = reinterpret_cast<uchar*>(data->data());
+
+	std::memcpy(image, &header, sizeof(Header));
+	std::memcpy(image + layout.nodes, nodes.constData(), nodes.count() * sizeof(Node));
+	qToLittleEndian<quint32>(word_offsets.constData(), word_offsets.count(), image + layout.word_offsets);
+	qToLittleEndian<quint16>(alphabet.constData(), alphabet.count(), image + layout.alphabet);
+
+	// Store which letters each node has as children
+	if (layout.child_masks != layout.word_offsets) {
+		uchar* masks = image + layout.child_masks;
+		for (const Node& node : nodes) {
+			quint64 mask = 0;
+			for (quint32 c = node.m_children, end = c + node.m_child_count; c < end; ++c) {
+				const quint16 letter = nodes.at(c).m_letter;
+				mask |= Q_UINT64_C(1) << (std::lower_bound(alphabet.cbegin(), alphabet.cend(), letter) - alphabet.cbegin());
+			}
+			qToLittleEndian<quint64>(mask, masks);
+			masks += sizeof(quint64);
 		}
 	}
-	return m_spellings.mid(node->m_word, node->m_word_count);
+
+	qToLittleEndian<quint32>(words.constData(), words.count(), image + layout.words);
+	qToLittleEndian<quint32>(spelling_offsets.constData(), spelling_offsets.count(), image + layout.spelling_offsets);
+	std::memcpy(image + layout.spelling_text, spelling_text.utf16(), spelling_text.length() * sizeof(char16_t));
+
+	reinterpret_cast<Header*>(image)->checksum = checksum(image, layout.size);
+
+	setImage(data, image, layout.size);
 }
 
 //-----------------------------------------------------------------------------
 
-QDataStream& operator<<(QDataStream& stream, const Trie& trie)
+bool Trie::setImage(const std::shared_ptr<const void>& data, const uchar* image, qint64 size)
 {
-	stream << trie.m_nodes << trie.m_spellings.join('\n');
-	return stream;
+	clear();
+
+	const Header* header = reinterpret_cast<const Header*>(image);
+	if ((size < qint64(sizeof(Header)))
+			|| (header->magic != TANGLET_CACHE_MAGICNUMBER)
+			|| (header->version != TANGLET_CACHE_VERSION)
+			|| (header->byte_order_mark != 0xFEFF)) {
+		return false;
+	}
+
+	const Layout layout(*header);
+	if (layout.size != size) {
+		return false;
+	}
+
+	m_data = data;
+	m_image = image;
+	m_image_size = size;
+	m_nodes = reinterpret_cast<const Node*>(image + layout.nodes);
+	m_node_count = header->node_count;
+	if (layout.child_masks != layout.word_offsets) {
+		m_child_masks = reinterpret_cast<const quint64_le*>(image + layout.child_masks);
+	}
+	m_alphabet = reinterpret_cast<const quint16_le*>(image + layout.alphabet);
+	m_alphabet_size = header->alphabet_size;
+	m_word_offsets = reinterpret_cast<const quint32_le*>(image + layout.word_offsets);
+	m_words = reinterpret_cast<const quint32_le*>(image + layout.words);
+	m_word_count = header->word_count;
+	m_spelling_offsets = reinterpret_cast<const quint32_le*>(image + layout.spelling_offsets);
+	m_spelling_count = header->spelling_count;
+	m_spelling_text = reinterpret_cast<const char16_t*>(image + layout.spelling_text);
+	m_spelling_text_size = header->spelling_text_size;
+
+	return !isEmpty();
+}
+
+//-----------------------------------------------------------------------------
+
+int Trie::code(const QChar& letter) const
+{
+	const quint16_le* end = m_alphabet + m_alphabet_size;
+	const quint16_le* i = std::lower_bound(m_alphabet, end, letter.unicode(), [](quint16 a, quint16 b) {
+		return a < b;
+	});
+	return ((i != end) && (*i == letter.unicode())) ? int(i - m_alphabet) : -1;
 }
 
 //-----------------------------------------------------------------------------
 
-QDataStream& operator>>(QDataStream& stream, Trie& trie)
+const Trie::Node* Trie::child(const QChar& letter, const Node* node) const
 {
-	QString spellings;
-	stream >> trie.m_nodes >> spellings;
-	trie.checkNodes();
-	if (!trie.isEmpty()) {
-		trie.m_spellings = spellings.split('\n');
+	if (m_child_masks) {
+		return child(code(letter), node);
+	}
+
+	const Node* end = m_nodes + node->m_children + node->m_child_count;
+	for (const Node* i = m_nodes + node->m_children; i < end; ++i) {
+		if (*i == letter) {
+			return i;
+		}
 	}
-	return stream;
+	return nullptr;
 }
 
 //-----------------------------------------------------------------------------
 
-QDataStream& operator<<(QDataStream& stream, const Trie::Node& node)
+Trie::Spellings Trie::spellings(const QString& word) const
 {
-	stream << node.m_letter << node.m_word << node.m_children << node.m_word_count << node.m_child_count;
-	return stream;
+	const Trie::Node* node = &m_nodes[0];
+	quint32 index = 0;
+	const int length = word.length();
+	for (int i = 0; i < length; ++i) {
+		const Trie::Node* next = child(word.at(i), node);
+		if (!next) {
+			return Spellings();
+		}
+		index += node->isWord() + wordOffset(next);
+		node = next;
+	}
+
+	if (!node->isWord() || (index >= m_word_count)) {
+		return Spellings();
+	}
+	const quint32 first = m_words[index];
+	const int count = m_words[index + 1] - first;
+	return Spellings(m_spelling_offsets + first, m_spelling_text, count, !count);
 }
 
 //-----------------------------------------------------------------------------
 
-QDataStream& operator>>(QDataStream& stream, Trie::Node& node)
+QStringList Trie::Spellings::toStringList(const QString& word) const
 {
-	stream >> node.m_letter >> node.m_word >> node.m_children >> node.m_word_count >> node.m_child_count;
-	return stream;
+	QStringList spellings;
+	if (m_lowercase) {
+		spellings.append(word.toLower());
+	}
+	for (int i = 0; i < m_count; ++i) {
+		spellings.append(at(i).toString());
+	}
+	return spellings;
 }
 
 //-----------------------------------------------------------------------------
@@ -8,9 +8,12 @@
 #define TANGLET_TRIE_H
 
 #include <QChar>
-#include <QHash>
 #include <QStringList>
-class QDataStream;
+#include <QStringView>
+#include <QtAlgorithms>
+#include <QtEndian>
+
+#include <memory>
 
 /**
  * @brief The Trie class contains a word list for fast lookup.
@@ -23,15 +26,22 @@ public:
 	 */
 	struct Node
 	{
+		/**
+		 * Flags describing a node.
+		 */
+		enum Flags
+		{
+			Word = 0x01 /**< the node is the last letter of a word */
+		};
+
 		/**
 		 * Constructs a node instance.
 		 */
 		Node()
-			: m_letter(QChar())
-			, m_word(0)
-			, m_children(0)
-			, m_word_count(0)
+			: m_letter(0)
+			, m_flags(0)
 			, m_child_count(0)
+			, m_children(0)
 		{
 		}
 
@@ -48,7 +58,7 @@ public:
 		 */
 		bool isWord() const
 		{
-			return m_word_count;
+			return m_flags & Word;
 		}
 
 		/**
@@ -58,14 +68,94 @@ public:
 		 */
 		bool operator==(const QChar& c) const
 		{
-			return c == m_letter;
+			return c.unicode() == m_letter;
 		}
 
-		QChar m_letter; /**< letter represented by the node */
-		quint32 m_word; /**< offset into word list if this node is a word */
-		quint32 m_children; /**< offset into the node list for children of node */
-		quint8 m_word_count; /**< how many spellings of the word the node has */
+		quint16_le m_letter; /**< letter represented by the node */
+		quint8 m_flags; /**< details of the node */
 		quint8 m_child_count; /**< how many children the node has */
+		quint32_le m_children; /**< offset into the node list for children of node */
+	};
+
+	/**
+	 * @brief The Spellings class is a view of the spellings of a word in the trie.
+	 */
+	class Spellings
+	{
+	public:
+		/**
+		 * Constructs an empty view.
+		 */
+		Spellings()
+			: m_offsets(nullptr)
+			, m_text(nullptr)
+			, m_count(0)
+			, m_lowercase(false)
+		{
+		}
+
+		/**
+		 * Constructs a view of spellings.
+		 * @param offsets where each spelling starts in @p text, followed by where the last one ends
+		 * @param text the spellings blob
+		 * @param count how many spellings there are
+		 * @param lowercase whether the word is only spelled as the lowercase of itself
+		 */
+		Spellings(const quint32_le* offsets, const char16_t* text, int count, bool lowercase)
+			: m_offsets(offsets)
+			, m_text(text)
+			, m_count(count)
+			, m_lowercase(lowercase)
+		{
+		}
+
+		/**
+		 * @return whether the word was not found
+		 */
+		bool isEmpty() const
+		{
+			return !m_count && !m_lowercase;
+		}
+
+		/**
+		 * @return whether the word is only spelled as the lowercase of itself, which is not stored
+		 */
+		bool isLowercase() const
+		{
+			return m_lowercase;
+		}
+
+		/**
+		 * @return how many spellings are stored for the word
+		 */
+		int count() const
+		{
+			return m_count;
+		}
+
+		/**
+		 * Fetches a stored spelling.
+		 * @param index which spelling to fetch
+		 * @return view of the spelling
+		 */
+		QStringView at(int index) const
+		{
+			const quint32 start = m_offsets[index];
+			return QStringView(m_text + start, m_offsets[index + 1] - start);
+		}
+
+		/**
+		 * Copies the spellings into a list.
+		 * @param word the word used for the lowercase spelling
+		 * @return list of spellings
+		 */
+		QStringList toStringList(const QString& word) const;
+
+	private:
+		const quint32_le* m_offsets; /**< where each spelling starts */
+		const char16_t* m_text; /**< the spellings blob */
+		int m_count; /**< how many spellings are stored */
+		bool m_lowercase; /**< whether the word is only spelled as the lowercase of itself */
 	};
 
 public:
@@ -81,16 +171,42 @@ public:
 	explicit Trie(const QString& word);
 
 	/**
-	 * Constructs a trie instance from a word list.
-	 * @param data contents of a word list file including alternate spellings
+	 * Builds the trie from a word list file. The file is parsed while it is being decompressed,
+	 * and the words of each block are added as soon as they are parsed, so the whole word list
+	 * is never held in memory.
+	 * @param path location of the gzip compressed word list
+	 * @param minimize whether to share identical suffixes between words (a DAWG)
+	 * @return @c true if the word list was read and contained words
 	 */
-	explicit Trie(const QByteArray& data);
+	bool build(const QString& path, bool minimize = true);
 
 	/**
 	 * Removes all nodes and spellings.
 	 */
 	void clear();
 
+	/**
+	 * Maps a cached trie into memory. The file stays open until the trie is cleared or replaced.
+	 * The checksum stored in the cache is verified before it is used.
+	 * @param path location of the cache file
+	 * @return @c true if the cache was valid and has been loaded
+	 */
+	bool load(const QString& path);
+
+	/**
+	 * Writes the trie to a cache file that can later be mapped with load().
+	 * @param path location of the cache file
+	 * @return @c true if the cache was written
+	 */
+	bool save(const QString& path) const;
+
+	/**
+	 * Checks if a file is a cached trie in the current format without verifying its checksum.
+	 * @param path location of the file
+	 * @return @c true if the file can be loaded with load() unless it is damaged
+	 */
+	static bool isCache(const QString& path);
+
 	/**
 	 * @return the top-level node of the trie
 	 */
@@ -107,66 +223,107 @@ public:
 	 */
 	const Node* child(const QChar& letter, const Node* node) const;
 
+	/**
+	 * Fetches a child node.
+	 * @param code the code of the letter to check for
+	 * @param node the parent node
+	 * @return child node or @c nullptr if no child matches @p code
+	 */
+	const Node* child(int code, const Node* node) const
+	{
+		if (code < 0) {
+			return nullptr;
+		}
+		if (!m_child_masks) {
+			return child(QChar(char16_t(m_alphabet[code])), node);
+		}
+
+		const quint64 bit = Q_UINT64_C(1) << code;
+		const quint64 mask = m_child_masks[node - m_nodes];
+		if (!(mask & bit)) {
+			return nullptr;
+		}
+		return m_nodes + node->m_children + qPopulationCount(mask & (bit - 1));
+	}
+
+	/**
+	 * Finds the code of a letter for use with child(int, const Node*).
+	 * @param letter the letter to look up
+	 * @return position of the letter in the alphabet or @c -1 if the trie does not contain it
+	 */
+	int code(const QChar& letter) const;
+
 	/**
 	 * Fetches the spellings of a word.
 	 * @param word the word to look up
-	 * @param default_value fallback list of spellings
-	 * @return spellings of a word
+	 * @return view of the spellings of a word, which is empty if the trie does not contain it
 	 */
-	QStringList spellings(const QString& word, const QStringList& default_value = QStringList()) const;
+	Spellings spellings(const QString& word) const;
 
 	/**
-	 * @return whether the trie is empty
+	 * Finds how many words come before a node among its siblings. The number of a word is the
+	 * sum of this and the word flag of each parent along the path to the word.
+	 * @param node the node to check
+	 * @return offset of the first word reached through @p node
 	 */
-	bool isEmpty() const
+	quint32 wordOffset(const Node* node) const
 	{
-		return m_nodes.isEmpty();
+		return m_word_offsets[node - m_nodes];
 	}
 
-	friend QDataStream& operator<<(QDataStream& stream, const Trie& trie);
-	friend QDataStream& operator>>(QDataStream& stream, Trie& trie);
+	/**
+	 * @return how many words are in the trie
+	 */
+	quint32 wordCount() const
+	{
+		return m_word_count;
+	}
 
-private:
 	/**
-	 * Verify that no nodes reference outside the list of nodes.
+	 * @return whether the trie is empty
 	 */
-	void checkNodes();
+	bool isEmpty() const
+	{
+		return !m_node_count;
+	}
 
 private:
-	QList<Node> m_nodes; /**< list of nodes */
-	QStringList m_spellings; /**< list of words */
-};
-
-/**
- * Writes a trie to a data stream.
- * @param stream the output stream
- * @param trie the trie to write
- * @return reference to the stream
- */
-QDataStream& operator<<(QDataStream& stream, const Trie& trie);
+	/**
+	 * Builds the image of the trie in memory.
+	 * @param nodes the list of nodes in breadth-first order
+	 * @param word_offsets how many words come before each node among its siblings
+	 * @param words the first spelling of each word in depth-first order, followed by the spelling count
+	 * @param spelling_offsets where each spelling starts in @p spelling_text, followed by its length
+	 * @param spelling_text the text of every spelling
+	 */
+	void setData(const QList<Node>& nodes, const QList<quint32>& word_offsets, const QList<quint32>& words, const QList<quint32>& spelling_offsets, const QString& spelling_text);
 
-/**
- * Reads a trie from a data stream.
- * @param stream the input stream
- * @param trie the trie to read into
- * @return reference to the stream
- */
-QDataStream& operator>>(QDataStream& stream, Trie& trie);
+	/**
+	 * Points the trie at an image after verifying its header.
+	 * @param data the memory that holds the image
+	 * @param image the start of the image
+	 * @param size how many bytes are in the image
+	 * @return @c true if the image is valid
+	 */
+	bool setImage(const std::shared_ptr<const void>& data, const uchar* image, qint64 size);
 
-/**
- * Writes a trie node to a data stream.
- * @param stream the output stream
- * @param node the trie node to write
- * @return reference to the stream
- */
-QDataStream& operator<<(QDataStream& stream, const Trie::Node& node);
+private:
+	std::shared_ptr<const void> m_data; /**< keeps the memory of the image alive */
+	const uchar* m_image; /**< start of the image */
+	qint64 m_image_size; /**< how many bytes are in the image */
 
-/**
- * Reads a trie node from a data stream.
- * @param stream the input stream
- * @param node the trie node to read into
- * @return reference to the stream
- */
-QDataStream& operator>>(QDataStream& stream, Trie::Node& node);
+	const Node* m_nodes; /**< list of nodes */
+	quint32 m_node_count; /**< how many nodes are in the trie */
+	const quint64_le* m_child_masks; /**< which letters each node has as children */
+	const quint16_le* m_alphabet; /**< sorted list of letters in the trie */
+	quint32 m_alphabet_size; /**< how many letters are in the alphabet */
+	const quint32_le* m_word_offsets; /**< how many words come before each node among its siblings */
+	const quint32_le* m_words; /**< first spelling of each word */
+	quint32 m_word_count; /**< how many words are in the trie */
+	const quint32_le* m_spelling_offsets; /**< offsets of each spelling into the spellings blob */
+	quint32 m_spelling_count; /**< how many spellings are in the trie */
+	const char16_t* m_spelling_text; /**< UTF-16 text of words in host byte order */
+	quint32 m_spelling_text_size; /**< how many code units are in the spellings blob */
+};
 
 #endif // TANGLET_TRIE_H
@@ -443,7 +443,7 @@ public:
 
 //-----------------------------------------------------------------------------
 
-Window::Window(const QString& file)
+Window::Window(const QString& file, quint64 seed)
 	: m_pause_action(nullptr)
 	, m_previous_state(nullptr)
 {
@@ -576,15 +576,18 @@ Window::Window(const QString& file)
 	// Start game
 	QString current = file;
 	if (settings.contains("Current/Version")) {
-		if (current.isEmpty() ||
+		if ((current.isEmpty() && !seed) ||
 				QMessageBox::question(this, tr("Question"), tr("End the current game?"), QMessageBox::Yes | QMessageBox::No, QMessageBox::No) == QMessageBox::No) {
 			current = ":saved:";
+			seed = 0;
 		}
 	}
 
 	m_state->finish();
 	m_contents->setCurrentIndex(3);
-	if (current.isEmpty()) {
+	if (seed && current.isEmpty()) {
+		startGame(QString(), seed);
+	} else if (current.isEmpty()) {
 		newGame();
 	} else {
 		startGame(current);
@@ -804,6 +807,9 @@ void Window::shareGame()
 		game.setValue("Minimum", settings.value("Minimum"));
 		game.setValue("TimerMode", settings.value("TimerMode"));
 		game.setValue("Letters", settings.value("Letters"));
+		if (settings.contains("Seed")) {
+			game.setValue("Seed", settings.value("Seed"));
+		}
 		game.setValue("Locale", settings.value("Locale"));
 		game.setValue("Dictionary", settings.value("Dictionary"));
 
@@ -984,7 +990,7 @@ void Window::monitorVisibility(QMenu* menu)
 
 //-----------------------------------------------------------------------------
 
-void Window::startGame(const QString& filename)
+void Window::startGame(const QString& filename, quint64 seed)
 {
 	QSettings settings;
 
@@ -994,7 +1000,7 @@ void Window::startGame(const QString& filename)
 		settings.sync();
 		m_state->newGame();
 		settings.beginGroup("Board");
-		m_board->generate(settings);
+		m_board->generate(settings, seed);
 	} else if (filename == ":saved:") {
 		// Continue previous game
 		m_state->openGame();
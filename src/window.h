@@ -35,8 +35,9 @@ public:
 	/**
 	 * Constructs a main window instance.
 	 * @param file a game file to load instead of the previous game
+	 * @param seed the seed of a board to replay instead of the previous game, or @c 0
 	 */
-	explicit Window(const QString& file = QString());
+	explicit Window(const QString& file = QString(), quint64 seed = 0);
 
 	/**
 	 * Override eventFilter to detect click on pause or new game screens.
@@ -181,8 +182,9 @@ private:
 	/**
 	 * Actually starts a new game.
 	 * @param filename location of the game data
+	 * @param seed the seed of a board to replay when starting a new game, or @c 0
 	 */
-	void startGame(const QString& filename = QString());
+	void startGame(const QString& filename = QString(), quint64 seed = 0);
 
 	/**
 	 * Tracks if a menu is shown to set the game in the autopause state.
@@ -75,7 +75,8 @@ QTreeWidgetItem* WordTree::addWord(const QString& word)
 		item->setText(0, copy);
 	}
 
-	QStringList spellings = m_trie->spellings(word, QStringList(item->text(0).toLower()));
+	const Trie::Spellings found = m_trie->spellings(word);
+	QStringList spellings = found.isEmpty() ? QStringList(item->text(0).toLower()) : found.toStringList(word);
 	item->setData(1, Qt::UserRole, spellings);
 
 	item->setIcon(1, QIcon(":/empty.png"));
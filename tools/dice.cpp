@@ -72,7 +72,7 @@ std::vector<QString> readWords(const QString& path)
 
 //-----------------------------------------------------------------------------
 
-void saveDice(const QString& path, const std::vector<QString>& small, const std::vector<QString>& large)
+void saveDice(const QString& path, const std::vector<std::vector<QString>>& sets)
 {
 	QFile out(path);
 	if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
@@ -81,14 +81,13 @@ void saveDice(const QString& path, const std::vector<QString>& small, const std:
 
 	QTextStream stream(&out);
 
-	for (const QString& line : small) {
-		stream << line << '\n';
-	}
-
-	stream << '\n';
-
-	for (const QString& line : large) {
-		stream << line << '\n';
+	for (size_t i = 0; i < sets.size(); ++i) {
+		if (i > 0) {
+			stream << '\n';
+		}
+		for (const QString& line : sets[i]) {
+			stream << line << '\n';
+		}
 	}
 
 	out.close();
@@ -369,11 +368,21 @@ int main(int argc, char** argv)
 
 		// Create dice
 		const auto letters = findLetterFrequency(words, use_bigrams, discard_infrequent);
-		const auto small = generateDice(letters, 16, random);
-		const auto large = generateDice(letters, 25, random);
+		std::vector<std::vector<QString>> sets;
+		sets.push_back(generateDice(letters, 16, random));
+		sets.push_back(generateDice(letters, 25, random));
+
+		// Create optional dice for larger boards
+		for (int size = 6; size <= 8; ++size) {
+			try {
+				sets.push_back(generateDice(letters, size * size, random));
+			} catch (const std::exception& err) {
+				std::cout << QString("Skipped %1x%1 dice: %2").arg(size).arg(err.what()).toStdString() << std::endl;
+			}
+		}
 
 		// Save dice to disk
-		saveDice(outfilename, small, large);
+		saveDice(outfilename, sets);
 	} catch (const std::exception& err) {
 		std::cerr << err.what() << std::endl;
 		return -1;
@@ -0,0 +1,154 @@
+/*
+	SPDX-FileCopyrightText: 2026 Graeme Gott <graeme@gottcode.org>
+
+	SPDX-License-Identifier: GPL-3.0-or-later
+*/
+
+#include "batch_solver.h"
+#include "trie.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QRegularExpression>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+#include <iostream>
+#include <stdexcept>
+
+//-----------------------------------------------------------------------------
+
+class Exception : public std::runtime_error
+{
+public:
+	explicit Exception(const QString& what_arg) : runtime_error(what_arg.toStdString()) { }
+	explicit Exception(const std::string& what_arg) : runtime_error(what_arg) { }
+	explicit Exception(const char* what_arg) : runtime_error(what_arg) { }
+};
+
+//-----------------------------------------------------------------------------
+
+QList<QStringList> readBoards(const QString& path)
+{
+	QFile file;
+	if (path == "-") {
+		if (!file.open(stdin, QIODevice::ReadOnly | QIODevice::Text)) {
+			throw Exception("Unable to read boards from standard input.");
+		}
+	} else {
+		file.setFileName(path);
+		if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+			throw Exception("Unable to open file '" + path + "' for reading.");
+		}
+	}
+
+	// Read boards, one per line, with letters separated by commas or spaces
+	const QRegularExpression separators("[,\\s]+");
+	QList<QStringList> boards;
+	QTextStream stream(&file);
+	while (!stream.atEnd()) {
+		const QString line = stream.readLine().trimmed();
+		if (line.isEmpty() || line.startsWith('#')) {
+			continue;
+		}
+
+		QStringList letters = line.split(separators, Qt::SkipEmptyParts);
+
+		// Treat a board without separators as one letter per cell
+		if (letters.count() == 1) {
+			letters.clear();
+			for (const QChar& letter : line) {
+				letters.append(QString(letter));
+			}
+		}
+
+		boards.append(letters);
+	}
+
+	return boards;
+}
+
+//-----------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+	QCoreApplication app(argc, argv);
+
+	try {
+		QCommandLineParser parser;
+		parser.setApplicationDescription("Solve Tanglet boards in bulk.");
+		parser.addHelpOption();
+		parser.addOption(QCommandLineOption({"l", "list"}, "List the words found on each board."));
+		parser.addOption(QCommandLineOption({"m", "minimum"}, "Only count words of at least <length> letters.", "length", "3"));
+		parser.addOption(QCommandLineOption({"o", "output"}, "Write results to <output> instead of standard output.", "output"));
+		parser.addOption(QCommandLineOption({"s", "score-words"}, "Only score the <count> highest scoring words.", "count", "-1"));
+		parser.addOption(QCommandLineOption({"t", "threads"}, "Solve with <count> threads instead of one per core.", "count"));
+		parser.addOption(QCommandLineOption({"w", "width"}, "Boards are <width> cells wide instead of square.", "width", "0"));
+		parser.addPositionalArgument("words", "The gzip compressed Tanglet <words> list.");
+		parser.addPositionalArgument("boards", "The <boards> file, one board per line, or - for standard input.");
+		parser.process(app);
+
+		const QStringList files = parser.positionalArguments();
+		if (files.size() != 2) {
+			parser.showHelp();
+		}
+
+		// Load word list
+		Trie trie;
+		if (!trie.build(files.at(0))) {
+			throw Exception("Unable to read words from file '" + files.at(0) + "'.");
+		}
+
+		// Solve boards
+		const QList<QStringList> boards = readBoards(files.at(1));
+
+		BatchSolver solver(trie, parser.value("minimum").toInt());
+		solver.setKeepWords(parser.isSet("list"));
+		solver.setMaximumWords(parser.value("score-words").toInt());
+		solver.setWidth(parser.value("width").toInt());
+		if (parser.isSet("threads")) {
+			solver.setThreadCount(parser.value("threads").toInt());
+		}
+		const QList<BatchSolver::Result> results = solver.solve(boards);
+
+		// Write results as tab separated letters, word count, score, and words
+		QFile out;
+		if (parser.isSet("output")) {
+			out.setFileName(parser.value("output"));
+			if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+				throw Exception("Unable to open file '" + out.fileName() + "' for writing.");
+			}
+		} else if (!out.open(stdout, QIODevice::WriteOnly | QIODevice::Text)) {
+			throw Exception("Unable to write results to standard output.");
+		}
+
+		QTextStream stream(&out);
+		int invalid = 0;
+		for (qsizetype i = 0, count = boards.count(); i < count; ++i) {
+			const BatchSolver::Result& result = results.at(i);
+			if (result.count == -1) {
+				++invalid;
+				continue;
+			}
+
+			stream << boards.at(i).join(',') << '\t' << result.count << '\t' << result.score;
+			if (parser.isSet("list")) {
+				stream << '\t' << result.words.join(' ');
+			}
+			stream << '\n';
+		}
+		stream.flush();
+
+		if (invalid) {
+			std::cerr << "Skipped " << invalid << " boards of invalid size." << std::endl;
+		}
+	} catch (const std::exception& err) {
+		std::cerr << err.what() << std::endl;
+		return -1;
+	}
+}
+
+//-----------------------------------------------------------------------------